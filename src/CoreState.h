@@ -3,6 +3,7 @@
 #include "AssetStore.h"
 #include "DASDirection.h"
 #include "DisplayMode.h"
+#include "FrameProfiler.h"
 #include "Game.h"
 #include "GuiScreenManager.h"
 #include "Video/Screen.h"
@@ -12,11 +13,15 @@
 #include "Input/KeyFlags.h"
 #include "Input/Mouse.h"
 #include "Player.h"
+#include "PresentationSink.h"
 #include "Settings.h"
 #include "RecordList.h"
+#include "RecordWriter.h"
 #include "SDL.h"
 #include <vector>
 #define RECENT_FRAMES 60
+#define REPLAY_SEEK_STEP (10 * 60)
+#define REPLAY_FAST_FORWARD_RATE 8
 
 struct CoreState {
     CoreState() = delete;
@@ -38,6 +43,7 @@ struct CoreState {
     bool process_events();
 
     void handle_replay_input();
+    void handle_replay_seek();
     void update_input_repeat();
     void update_pressed();
 
@@ -83,6 +89,7 @@ struct CoreState {
     std::vector<gfx_button> gfx_buttons;
     // TODO: Replace all gfx_* code with the new Gfx system.
     Shiro::Gfx gfx;
+    Shiro::CoreStateSink sink;
 
     Shiro::KeyFlags prev_keys_raw;
     Shiro::KeyFlags keys_raw;
@@ -98,6 +105,10 @@ struct CoreState {
     bool menu_input_override;
     bool button_emergency_override;
 
+    // replay viewer controls: pending seek in steps of REPLAY_SEEK_STEP frames, and fast-forward held
+    int replay_seek_steps;
+    bool replay_fast_forward;
+
     game_t *p1game;
     game_t *menu;
     struct pracdata *pracdata_mirror;
@@ -109,11 +120,15 @@ struct CoreState {
     //long double avg_sleep_ms;
     //long double avg_sleep_ms_recent;
     unsigned long frames;
+    // per-phase timings of the main loop; F10 toggles it and its overlay, Shift+F10 dumps a trace
+    Shiro::FrameProfiler profiler;
 
     //long double avg_sleep_ms_recent_array[RECENT_FRAMES];
     //int recent_frame_overload;
 
     Shiro::RecordList records;
+    // writes to records' database off the game thread
+    Shiro::RecordWriter recordWriter;
     // struct scoredb archive;
     Shiro::Player player;
 };
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "FieldEditHistory.h"
+#include <utility>
+
+Shiro::FieldEditHistory::FieldEditHistory() :
+    inStroke(false) {}
+
+Shiro::FieldEditHistory::FieldEditHistory(const FieldEditHistory& other) :
+    undoStrokes(other.undoStrokes),
+    redoStrokes(other.redoStrokes),
+    inStroke(false) {}
+
+Shiro::FieldEditHistory& Shiro::FieldEditHistory::operator=(const FieldEditHistory& other) {
+    undoStrokes = other.undoStrokes;
+    redoStrokes = other.redoStrokes;
+    base = Grid();
+    inStroke = false;
+    return *this;
+}
+
+void Shiro::FieldEditHistory::begin(const Grid& field) {
+    end(field);
+    redoStrokes.clear();
+    base = field;
+    inStroke = true;
+}
+
+void Shiro::FieldEditHistory::end(const Grid& field) {
+    if (!inStroke) {
+        return;
+    }
+    inStroke = false;
+    // only needed while the stroke is open; dropping it keeps copies of the history as small as the strokes
+    const Grid strokeBase = std::move(base);
+    base = Grid();
+
+    if (field.getWidth() != strokeBase.getWidth() || field.getHeight() != strokeBase.getHeight()) {
+        return;
+    }
+
+    Stroke stroke;
+    const std::size_t width = field.getWidth();
+    for (std::size_t y = 0u; y < field.getHeight(); y++) {
+        for (std::size_t x = 0u; x < width; x++) {
+            const int before = strokeBase.getCell(x, y);
+            const int after = field.getCell(x, y);
+            if (before != after) {
+                stroke.push_back({ static_cast<std::uint16_t>(y * width + x), before, after });
+            }
+        }
+    }
+
+    if (!stroke.empty()) {
+        stroke.shrink_to_fit();
+        undoStrokes.push_back(std::move(stroke));
+    }
+}
+
+bool Shiro::FieldEditHistory::undo(Grid& field) {
+    if (undoStrokes.empty()) {
+        return false;
+    }
+
+    const int width = static_cast<int>(field.getWidth());
+    for (const CellChange& change : undoStrokes.back()) {
+        field.cell(change.index % width, change.index / width) = change.before;
+    }
+    redoStrokes.push_back(std::move(undoStrokes.back()));
+    undoStrokes.pop_back();
+
+    return true;
+}
+
+bool Shiro::FieldEditHistory::redo(Grid& field) {
+    if (redoStrokes.empty()) {
+        return false;
+    }
+
+    const int width = static_cast<int>(field.getWidth());
+    for (const CellChange& change : redoStrokes.back()) {
+        field.cell(change.index % width, change.index / width) = change.after;
+    }
+    undoStrokes.push_back(std::move(redoStrokes.back()));
+    redoStrokes.pop_back();
+
+    return true;
+}
+
+void Shiro::FieldEditHistory::clear() {
+    undoStrokes.clear();
+    redoStrokes.clear();
+    base = Grid();
+    inStroke = false;
+}
+
+std::size_t Shiro::FieldEditHistory::undoSize() const {
+    return undoStrokes.size() + (inStroke ? 1u : 0u);
+}
+
+std::size_t Shiro::FieldEditHistory::redoSize() const {
+    return redoStrokes.size();
+}
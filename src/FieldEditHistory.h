@@ -0,0 +1,74 @@
+#pragma once
+#include "Grid.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Shiro {
+    /**
+     * Undo/redo history for the practice field editor. An entry is one edit
+     * stroke, from the first cell it changes until the mouse is let go, and
+     * holds only the cells the stroke changed, with their values before and
+     * after it. Undoing or redoing a stroke, and copying the history, cost as
+     * much as the strokes involved instead of a copy of the field per step.
+     */
+    class FieldEditHistory {
+    public:
+        FieldEditHistory();
+
+        /**
+         * Copies the recorded strokes only. A stroke in progress isn't
+         * carried over; the copy can't tell which of the field's cells it
+         * changed.
+         */
+        FieldEditHistory(const FieldEditHistory& other);
+        FieldEditHistory& operator=(const FieldEditHistory& other);
+        FieldEditHistory(FieldEditHistory&&) = default;
+        FieldEditHistory& operator=(FieldEditHistory&&) = default;
+
+        /**
+         * Called before a stroke first changes `field`. Records the previous
+         * stroke if it wasn't ended, and forgets everything that was undone.
+         */
+        void begin(const Grid& field);
+
+        /**
+         * Records the cells the current stroke changed; does nothing if no
+         * stroke was begun.
+         */
+        void end(const Grid& field);
+
+        /**
+         * Reverts the newest recorded stroke in `field`. Returns false if
+         * there's nothing to undo.
+         */
+        bool undo(Grid& field);
+
+        /**
+         * Reapplies the newest undone stroke to `field`. Returns false if
+         * there's nothing to redo.
+         */
+        bool redo(Grid& field);
+
+        void clear();
+
+        // the stroke in progress counts as an undo step
+        std::size_t undoSize() const;
+        std::size_t redoSize() const;
+
+    private:
+        struct CellChange {
+            std::uint16_t index; // y * field width + x
+            int before;
+            int after;
+        };
+
+        using Stroke = std::vector<CellChange>;
+
+        std::vector<Stroke> undoStrokes;
+        std::vector<Stroke> redoStrokes;
+        // the field as the current stroke began; empty between strokes
+        Grid base;
+        bool inStroke;
+    };
+}
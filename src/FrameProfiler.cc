@@ -0,0 +1,173 @@
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <iostream>
+
+Shiro::FrameProfiler::Scope::Scope(FrameProfiler& profiler, Phase phase) :
+    profiler(profiler.enabled() ? &profiler : nullptr),
+    phase(phase) {
+    if (this->profiler) {
+        begin = Clock::now();
+    }
+}
+
+Shiro::FrameProfiler::Scope::~Scope() {
+    if (profiler) {
+        profiler->record(phase, begin, Clock::now());
+    }
+}
+
+Shiro::FrameProfiler::FrameProfiler() :
+    slots(new Slot[capacity]),
+    written(0u),
+    on(false),
+    frame(0u),
+    epoch(Clock::now()) {}
+
+Shiro::FrameProfiler::~FrameProfiler() {
+    if (dumper.joinable()) {
+        dumper.join();
+    }
+}
+
+bool Shiro::FrameProfiler::enabled() const {
+    return on.load(std::memory_order_relaxed);
+}
+
+void Shiro::FrameProfiler::setEnabled(bool enabled) {
+    on.store(enabled, std::memory_order_relaxed);
+}
+
+void Shiro::FrameProfiler::beginFrame() {
+    frame++;
+}
+
+void Shiro::FrameProfiler::record(Phase phase, Clock::time_point begin, Clock::time_point end) {
+    const std::uint64_t n = written.load(std::memory_order_relaxed);
+    Slot& slot = slots[n % capacity];
+
+    // keeps the slot's stores from becoming visible before the last sample's publish; with copy()'s acquire fence,
+    // a reader that saw any of them also sees a written count that makes it drop the slot
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.beginNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(begin - epoch).count(), std::memory_order_relaxed);
+    slot.endNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(end - epoch).count(), std::memory_order_relaxed);
+    slot.frame.store(frame, std::memory_order_relaxed);
+    slot.phase.store(phase, std::memory_order_relaxed);
+
+    // publishes the slot to readers
+    written.store(n + 1u, std::memory_order_release);
+}
+
+std::array<Shiro::FrameProfiler::PhaseStats, Shiro::FrameProfiler::numPhases> Shiro::FrameProfiler::stats(std::uint32_t frames) const {
+    std::array<PhaseStats, numPhases> stats = {};
+    const std::uint64_t n = written.load(std::memory_order_acquire);
+    const std::uint64_t oldest = n > capacity ? n - capacity : 0u;
+
+    // newest first, until a sample from before the window
+    for (std::uint64_t i = n; i > oldest; i--) {
+        const Slot& slot = slots[(i - 1u) % capacity];
+        if (frame - slot.frame.load(std::memory_order_relaxed) >= frames) {
+            break;
+        }
+
+        PhaseStats& s = stats[static_cast<std::size_t>(slot.phase.load(std::memory_order_relaxed))];
+        const double ms = (slot.endNs.load(std::memory_order_relaxed) - slot.beginNs.load(std::memory_order_relaxed)) / 1000000.0;
+        s.averageMs += ms;
+        s.maxMs = std::max(s.maxMs, ms);
+        s.samples++;
+    }
+
+    for (PhaseStats& s : stats) {
+        if (s.samples) {
+            s.averageMs /= s.samples;
+        }
+    }
+
+    return stats;
+}
+
+std::size_t Shiro::FrameProfiler::copy(std::uint64_t first, std::unique_ptr<Sample[]>& out) const {
+    const std::uint64_t n = written.load(std::memory_order_acquire);
+    first = std::max(first, n > capacity ? n - capacity : std::uint64_t(0u));
+
+    out.reset(new Sample[n - first]);
+    for (std::uint64_t i = first; i < n; i++) {
+        const Slot& slot = slots[i % capacity];
+        out[i - first] = {
+            slot.beginNs.load(std::memory_order_relaxed),
+            slot.endNs.load(std::memory_order_relaxed),
+            slot.frame.load(std::memory_order_relaxed),
+            slot.phase.load(std::memory_order_relaxed)
+        };
+    }
+
+    // anything the writer got around to overwriting during the copy is torn, so it's dropped; that includes sample
+    // after - capacity, as record() rewrites its slot before publishing after + 1
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const std::uint64_t after = written.load(std::memory_order_relaxed);
+    const std::uint64_t intact = after + 1u > capacity ? after + 1u - capacity : 0u;
+    if (intact <= first) {
+        return n - first;
+    }
+    if (intact >= n) {
+        return 0u;
+    }
+
+    const std::size_t dropped = intact - first;
+    std::copy(out.get() + dropped, out.get() + (n - first), out.get());
+    return n - intact;
+}
+
+bool Shiro::FrameProfiler::writeTrace(const std::filesystem::path& path) const {
+    std::unique_ptr<Sample[]> samples;
+    const std::size_t count = copy(0u, samples);
+
+    std::FILE* file = std::fopen(path.string().c_str(), "w");
+    if (!file) {
+        return false;
+    }
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    for (std::size_t i = 0u; i < count; i++) {
+        const Sample& sample = samples[i];
+        // complete ("X") events; Chrome traces are in microseconds
+        std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%" PRIu32 "}}",
+            i ? ",\n" : "",
+            name(sample.phase),
+            sample.beginNs / 1000.0,
+            (sample.endNs - sample.beginNs) / 1000.0,
+            sample.frame);
+    }
+    std::fputs("\n]}\n", file);
+
+    return std::fclose(file) == 0;
+}
+
+void Shiro::FrameProfiler::writeTraceAsync(const std::filesystem::path& path) {
+    if (dumper.joinable()) {
+        dumper.join();
+    }
+
+    dumper = std::thread([this, path] {
+        if (writeTrace(path)) {
+            std::cerr << "Wrote frame profile to " << path << std::endl;
+        }
+        else {
+            std::cerr << "Couldn't write frame profile to " << path << std::endl;
+        }
+    });
+}
+
+const char* Shiro::FrameProfiler::name(Phase phase) {
+    switch (phase) {
+    case Phase::events: return "process_events";
+    case Phase::input: return "input";
+    case Phase::update: return "update";
+    case Phase::gfxUpdate: return "gfx.update";
+    case Phase::bgDraw: return "bg.draw";
+    case Phase::gfxDraw: return "gfx.draw";
+    case Phase::present: return "present";
+    default: return "?";
+    }
+}
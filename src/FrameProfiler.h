@@ -0,0 +1,130 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+namespace Shiro {
+    /**
+     * Runtime-toggleable timings of each phase of the main loop. While
+     * enabled, the loop records one sample per phase it runs into a
+     * fixed-size ring, so recording never allocates or locks; the oldest
+     * samples are overwritten.
+     *
+     * The ring has one writer, the main loop. It can be read from any
+     * thread while the loop keeps writing, which is how traces are dumped
+     * without stalling the game: a reader copies what it wants, then drops
+     * whatever the writer may have overwritten while it was copying.
+     */
+    class FrameProfiler {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        enum class Phase : std::uint8_t {
+            events,
+            input,
+            update,
+            gfxUpdate,
+            bgDraw,
+            gfxDraw,
+            present,
+            count
+        };
+
+        static constexpr std::size_t numPhases = static_cast<std::size_t>(Phase::count);
+        static constexpr std::size_t capacity = 1u << 15;
+
+        /**
+         * Times a phase from construction to destruction, if the profiler
+         * is enabled when it's constructed.
+         */
+        class Scope {
+        public:
+            Scope(FrameProfiler& profiler, Phase phase);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            FrameProfiler* profiler;
+            Phase phase;
+            Clock::time_point begin;
+        };
+
+        struct PhaseStats {
+            double averageMs;
+            double maxMs;
+            std::size_t samples;
+        };
+
+        FrameProfiler();
+        ~FrameProfiler();
+
+        FrameProfiler(const FrameProfiler&) = delete;
+        FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+        bool enabled() const;
+        void setEnabled(bool enabled);
+
+        /**
+         * Starts a new rendered frame; samples are tagged with the frame
+         * they were recorded in.
+         */
+        void beginFrame();
+
+        void record(Phase phase, Clock::time_point begin, Clock::time_point end);
+
+        /**
+         * Average and worst time of each phase over the last `frames`
+         * rendered frames.
+         */
+        std::array<PhaseStats, numPhases> stats(std::uint32_t frames) const;
+
+        /**
+         * Writes every sample still in the ring to `path` as a Chrome trace
+         * (JSON, viewable in chrome://tracing or Perfetto). Can be called
+         * from any thread.
+         */
+        bool writeTrace(const std::filesystem::path& path) const;
+
+        /**
+         * writeTrace on a background thread, so the loop doesn't stall;
+         * waits for the previous dump to finish first.
+         */
+        void writeTraceAsync(const std::filesystem::path& path);
+
+        static const char* name(Phase phase);
+
+    private:
+        struct Sample {
+            std::uint64_t beginNs; // since the profiler was created
+            std::uint64_t endNs;
+            std::uint32_t frame;
+            Phase phase;
+        };
+
+        // the slots are written by one thread and read by others, so every field is atomic
+        struct Slot {
+            std::atomic<std::uint64_t> beginNs;
+            std::atomic<std::uint64_t> endNs;
+            std::atomic<std::uint32_t> frame;
+            std::atomic<Phase> phase;
+        };
+
+        // copies the samples numbered [first, the current count) that are intact; returns how many
+        std::size_t copy(std::uint64_t first, std::unique_ptr<Sample[]>& out) const;
+
+        std::unique_ptr<Slot[]> slots;
+        // total number of samples ever recorded; sample n is in slots[n % capacity]
+        std::atomic<std::uint64_t> written;
+        std::atomic<bool> on;
+        std::uint32_t frame;
+        Clock::time_point epoch;
+        std::thread dumper;
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "Grid.h"
+#include "PresentationSink.h"
 #include "gfx_structures.h"
 typedef struct game game_t;
 struct game {
@@ -15,6 +16,7 @@ struct game {
     unsigned long frame_counter;
 
     CoreState *origin;
+    Shiro::PresentationSink *sink; // nullptr when running headless
     Shiro::Grid *field;
     void *data;
 };
@@ -0,0 +1,545 @@
+#include "GameSnapshot.h"
+#include "CoreState.h"
+#include "Grid.h"
+#include "PieceDefinition.h"
+#include "QRS0.h"
+#include "game_qs.h"
+#include "random.h"
+#include "replay.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace {
+    // Header::flags
+    constexpr std::uint8_t SNAPSHOT_HAS_DEF = 1u << 0;
+    constexpr std::uint8_t SNAPSHOT_HAS_HOLD = 1u << 1;
+    constexpr std::uint8_t SNAPSHOT_RECORDING = 1u << 2;
+    constexpr std::uint8_t SNAPSHOT_PLAYBACK = 1u << 3;
+
+    // everything needed to check a snapshot against a game and to size its variable-length parts
+    struct Header {
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint16_t reserved;
+        std::uint32_t modeFlags;
+        std::int32_t modeType;
+        std::int32_t randomizerType;
+        std::uint16_t fieldW;
+        std::uint16_t fieldH;
+        std::uint16_t numOlds;
+        std::uint16_t numPreviews;
+        std::uint32_t randomizerSize;
+        std::uint32_t recordedInputs;
+        std::uint8_t flags;
+    };
+
+    struct PieceRef {
+        piece_id id;
+        Shiro::PieceDefinitionFlag flags;
+    };
+
+    // the parts of the game outside qrsdata's progress fields
+    struct Body {
+        unsigned long frameCounter;
+        std::vector<int> cells;
+
+        PieceRef def;
+        unsigned state;
+        int x;
+        int y;
+        int orient;
+        int speeds; // see qs_speeds_index
+        std::vector<int> oldXs;
+        std::vector<int> oldYs;
+        QRS_Counters counters;
+
+        PieceRef hold;
+        std::vector<PieceRef> previews;
+
+        std::uint64_t time;
+        long randomizerSeed;
+        std::vector<std::uint8_t> randomizer;
+
+        // the replay being recorded, or the length of the one being played back
+        long replaySeed;
+        int replayStartingLevel;
+        time_t replayDate;
+        std::vector<std::uint8_t> replayInputs;
+        unsigned replayLen;
+
+        Shiro::KeyFlags keys;
+        Shiro::KeyFlags prevKeys;
+        Shiro::DASDirection holdDir;
+        unsigned holdTime;
+    };
+
+    /* Writer and Reader share the same interface, so one function per part of
+       the format serves both saving and restoring. Each call names the stored
+       width; the value is converted from or to whatever type the game uses. */
+    class Writer {
+    public:
+        explicit Writer(std::vector<std::uint8_t>& out) : out(out) {}
+
+        template<typename T> void u8(T& v) { put(static_cast<std::uint8_t>(v), 1u); }
+        template<typename T> void u16(T& v) { put(static_cast<std::uint16_t>(v), 2u); }
+        template<typename T> void u32(T& v) { put(static_cast<std::uint32_t>(v), 4u); }
+        template<typename T> void u64(T& v) { put(static_cast<std::uint64_t>(v), 8u); }
+        template<typename T> void i32(T& v) { put(static_cast<std::uint32_t>(static_cast<std::int32_t>(v)), 4u); }
+        template<typename T> void i64(T& v) { put(static_cast<std::uint64_t>(static_cast<std::int64_t>(v)), 8u); }
+        void boolean(bool& v) { put(v ? 1u : 0u, 1u); }
+        void f64(double& v) {
+            std::uint64_t bits;
+            std::memcpy(&bits, &v, sizeof(bits));
+            put(bits, 8u);
+        }
+
+        template<typename T, typename F> void sequence(std::vector<T>& v, std::size_t n, F each) {
+            assert(v.size() == n);
+            for (T& element : v) {
+                each(element);
+            }
+        }
+
+    private:
+        void put(std::uint64_t bits, std::size_t n) {
+            for (std::size_t i = 0u; i < n; i++) {
+                out.push_back(static_cast<std::uint8_t>(bits >> (8u * i)));
+            }
+        }
+
+        std::vector<std::uint8_t>& out;
+    };
+
+    class Reader {
+    public:
+        Reader(const std::uint8_t* data, std::size_t size) :
+            data(data),
+            size(size),
+            pos(0u),
+            ok(true) {}
+
+        template<typename T> void u8(T& v) { v = static_cast<T>(static_cast<std::uint8_t>(get(1u))); }
+        template<typename T> void u16(T& v) { v = static_cast<T>(static_cast<std::uint16_t>(get(2u))); }
+        template<typename T> void u32(T& v) { v = static_cast<T>(static_cast<std::uint32_t>(get(4u))); }
+        template<typename T> void u64(T& v) { v = static_cast<T>(get(8u)); }
+        template<typename T> void i32(T& v) { v = static_cast<T>(static_cast<std::int32_t>(static_cast<std::uint32_t>(get(4u)))); }
+        template<typename T> void i64(T& v) { v = static_cast<T>(static_cast<std::int64_t>(get(8u))); }
+        void boolean(bool& v) { v = get(1u) != 0u; }
+        void f64(double& v) {
+            const std::uint64_t bits = get(8u);
+            std::memcpy(&v, &bits, sizeof(v));
+        }
+
+        template<typename T, typename F> void sequence(std::vector<T>& v, std::size_t n, F each) {
+            // every element takes at least a byte, so a bad count can't make this allocate much
+            if (n > size - pos) {
+                ok = false;
+                return;
+            }
+            v.resize(n);
+            for (T& element : v) {
+                each(element);
+            }
+        }
+
+        bool good() const { return ok; }
+        bool atEnd() const { return pos == size; }
+        std::size_t position() const { return pos; }
+
+    private:
+        std::uint64_t get(std::size_t n) {
+            if (!ok || size - pos < n) {
+                ok = false;
+                return 0u;
+            }
+            std::uint64_t bits = 0u;
+            for (std::size_t i = 0u; i < n; i++) {
+                bits |= static_cast<std::uint64_t>(data[pos + i]) << (8u * i);
+            }
+            pos += n;
+            return bits;
+        }
+
+        const std::uint8_t* data;
+        std::size_t size;
+        std::size_t pos;
+        bool ok;
+    };
+}
+
+template<typename Archive>
+static void transfer_header(Archive& ar, Header& h) {
+    ar.u32(h.magic);
+    ar.u16(h.version);
+    ar.u16(h.reserved);
+    ar.u32(h.modeFlags);
+    ar.i32(h.modeType);
+    ar.i32(h.randomizerType);
+    ar.u16(h.fieldW);
+    ar.u16(h.fieldH);
+    ar.u16(h.numOlds);
+    ar.u16(h.numPreviews);
+    ar.u32(h.randomizerSize);
+    ar.u32(h.recordedInputs);
+    ar.u8(h.flags);
+}
+
+template<typename Archive>
+static void transfer_piece(Archive& ar, PieceRef& piece) {
+    ar.u8(piece.id);
+    ar.u32(piece.flags);
+}
+
+template<typename Archive>
+static void transfer_keys(Archive& ar, Shiro::KeyFlags& keys) {
+    ar.u8(keys.left);
+    ar.u8(keys.right);
+    ar.u8(keys.up);
+    ar.u8(keys.down);
+    ar.u8(keys.a);
+    ar.u8(keys.b);
+    ar.u8(keys.c);
+    ar.u8(keys.d);
+    ar.u8(keys.start);
+    ar.u8(keys.escape);
+}
+
+template<typename Archive>
+static void transfer_body(Archive& ar, const Header& h, Body& b) {
+    ar.u64(b.frameCounter);
+    ar.sequence(b.cells, std::size_t(h.fieldW) * h.fieldH, [&ar](int& cell) { ar.i32(cell); });
+
+    if (h.flags & SNAPSHOT_HAS_DEF) {
+        transfer_piece(ar, b.def);
+    }
+    ar.u32(b.state);
+    ar.i32(b.x);
+    ar.i32(b.y);
+    ar.i32(b.orient);
+    ar.i32(b.speeds);
+    ar.sequence(b.oldXs, h.numOlds, [&ar](int& x) { ar.i32(x); });
+    ar.sequence(b.oldYs, h.numOlds, [&ar](int& y) { ar.i32(y); });
+
+    ar.i32(b.counters.init);
+    ar.i32(b.counters.lock);
+    ar.i32(b.counters.are);
+    ar.i32(b.counters.lineare);
+    ar.i32(b.counters.lineclear);
+    ar.u32(b.counters.floorkicks);
+    ar.i32(b.counters.hold_flash);
+
+    if (h.flags & SNAPSHOT_HAS_HOLD) {
+        transfer_piece(ar, b.hold);
+    }
+    ar.sequence(b.previews, h.numPreviews, [&ar](PieceRef& piece) { transfer_piece(ar, piece); });
+
+    ar.u64(b.time);
+    ar.i64(b.randomizerSeed);
+    ar.sequence(b.randomizer, h.randomizerSize, [&ar](std::uint8_t& byte) { ar.u8(byte); });
+
+    if (h.flags & SNAPSHOT_RECORDING) {
+        ar.i64(b.replaySeed);
+        ar.i32(b.replayStartingLevel);
+        ar.i64(b.replayDate);
+        ar.sequence(b.replayInputs, h.recordedInputs, [&ar](std::uint8_t& input) { ar.u8(input); });
+    }
+    if (h.flags & SNAPSHOT_PLAYBACK) {
+        ar.u32(b.replayLen);
+    }
+
+    transfer_keys(ar, b.keys);
+    transfer_keys(ar, b.prevKeys);
+    ar.u8(b.holdDir);
+    ar.u32(b.holdTime);
+}
+
+/* The part of qrsdata that changes during gameplay (everything from
+   cur_piece_qrs_id down, plus the field width). q->music isn't stored, since
+   it tracks what's actually playing; restore resyncs it. */
+template<typename Archive>
+static void transfer_progress(Archive& ar, qrsdata& q) {
+    ar.i32(q.field_w);
+
+    ar.u8(q.cur_piece_qrs_id);
+    ar.u32(q.state_flags);
+    ar.i32(q.piece_seq_index);
+    ar.i32(q.garbage_row_index);
+    ar.i32(q.playback_index);
+    ar.i32(q.garbage_counter);
+    ar.i32(q.garbage_delay);
+    ar.i32(q.stack_anim_counter);
+    ar.i32(q.credit_roll_counter);
+    ar.i32(q.credit_roll_lineclears);
+
+    ar.u32(q.level);
+    ar.i32(q.section);
+    ar.f64(q.rank);
+
+    ar.i32(q.score);
+    ar.i32(q.soft_drop_counter);
+    ar.i32(q.sonic_drop_height);
+    ar.i32(q.active_piece_time);
+    ar.i32(q.placement_speed);
+    ar.i32(q.levelstop_time);
+
+    ar.u64(q.last_gradeup_timestamp);
+    ar.i32(q.grade);
+    ar.i32(q.internal_grade);
+    ar.i32(q.grade_points);
+    ar.i32(q.grade_decay_counter);
+
+    ar.boolean(q.mroll_unlocked);
+    ar.i64(q.cur_section_timestamp);
+    for (int& time : q.section_times) {
+        ar.i32(time);
+    }
+    for (int& tetrises : q.section_tetrises) {
+        ar.i32(tetrises);
+    }
+
+    ar.i32(q.lock_on_rotate);
+    ar.boolean(q.lock_held);
+    ar.i32(q.locking_row);
+    ar.i32(q.lvlinc);
+    ar.i32(q.lastclear);
+    ar.i32(q.combo);
+    ar.i32(q.combo_simple);
+    ar.i32(q.singles);
+    ar.i32(q.doubles);
+    ar.i32(q.triples);
+    ar.i32(q.tetrises);
+    ar.i32(q.pentrises);
+    ar.i32(q.recoveries);
+    ar.boolean(q.is_recovering);
+
+    ar.u64(q.last_medal_re_timestamp);
+    ar.u64(q.last_medal_sk_timestamp);
+    ar.u64(q.last_medal_st_timestamp);
+    ar.u64(q.last_medal_co_timestamp);
+
+    ar.i32(q.medal_re);
+    ar.i32(q.medal_sk);
+    ar.i32(q.medal_st);
+    ar.i32(q.medal_co);
+
+    ar.i32(q.speed_curve_index);
+}
+
+bool Shiro::GameSnapshot::save(const CoreState& cs, const game_t& g, std::vector<std::uint8_t>& out) {
+    qrsdata *q = static_cast<qrsdata *>(g.data);
+    const qrs_player *p = q->p1;
+    const Grid& field = *g.field;
+
+    out.clear();
+    if (q->pracdata || field.getWidth() > UINT16_MAX || field.getHeight() > UINT16_MAX) {
+        return false;
+    }
+
+    Header h = {};
+    h.magic = magic;
+    h.version = version;
+    h.modeFlags = q->mode_flags;
+    h.modeType = q->mode_type;
+    h.randomizerType = q->randomizer_type;
+    h.fieldW = static_cast<std::uint16_t>(field.getWidth());
+    h.fieldH = static_cast<std::uint16_t>(field.getHeight());
+    h.numOlds = static_cast<std::uint16_t>(p->num_olds);
+    h.numPreviews = static_cast<std::uint16_t>(q->previews.size());
+    h.randomizerSize = static_cast<std::uint32_t>(randomizer_state_size(q->randomizer));
+    h.recordedInputs = q->recording ? static_cast<std::uint32_t>(q->replay->pinputs.size()) : 0u;
+    h.flags = (p->def ? SNAPSHOT_HAS_DEF : 0u) |
+        (q->hold ? SNAPSHOT_HAS_HOLD : 0u) |
+        (q->recording ? SNAPSHOT_RECORDING : 0u) |
+        (q->playback ? SNAPSHOT_PLAYBACK : 0u);
+
+    Body b = {};
+    b.frameCounter = g.frame_counter;
+    b.cells.reserve(std::size_t(h.fieldW) * h.fieldH);
+    for (std::size_t y = 0u; y < h.fieldH; y++) {
+        for (std::size_t x = 0u; x < h.fieldW; x++) {
+            b.cells.push_back(field.getCell(x, y));
+        }
+    }
+
+    if (p->def) {
+        b.def = { p->def->qrsID, p->def->flags };
+    }
+    b.state = p->state;
+    b.x = p->x;
+    b.y = p->y;
+    b.orient = p->orient;
+    b.speeds = qs_speeds_index(p->speeds);
+    b.oldXs.assign(p->old_xs, p->old_xs + p->num_olds);
+    b.oldYs.assign(p->old_ys, p->old_ys + p->num_olds);
+    b.counters = *q->p1counters;
+
+    if (q->hold) {
+        b.hold = { q->hold->qrsID, q->hold->flags };
+    }
+    for (const auto& preview : q->previews) {
+        b.previews.push_back({ preview.qrsID, preview.flags });
+    }
+
+    b.time = q->timer.time;
+    b.randomizerSeed = q->randomizer_seed;
+    b.randomizer.resize(h.randomizerSize);
+    randomizer_save_state(q->randomizer, b.randomizer.data());
+
+    if (q->recording) {
+        b.replaySeed = q->replay->seed;
+        b.replayStartingLevel = q->replay->starting_level;
+        b.replayDate = q->replay->date;
+        for (std::size_t i = 0u; i < q->replay->pinputs.size(); i++) {
+            b.replayInputs.push_back(q->replay->pinputs[i].data);
+        }
+    }
+    if (q->playback) {
+        b.replayLen = static_cast<unsigned>(q->replay->pinputs.size());
+    }
+
+    b.keys = cs.keys;
+    b.prevKeys = cs.prev_keys;
+    b.holdDir = cs.hold_dir;
+    b.holdTime = cs.hold_time;
+
+    Writer writer(out);
+    transfer_header(writer, h);
+    transfer_body(writer, h, b);
+    transfer_progress(writer, *q);
+
+    return true;
+}
+
+bool Shiro::GameSnapshot::restore(CoreState& cs, game_t& g, const std::uint8_t* data, std::size_t size) {
+    qrsdata *q = static_cast<qrsdata *>(g.data);
+    qrs_player *p = q->p1;
+    Grid& field = *g.field;
+
+    // the whole snapshot is read and checked before the game is touched
+    Reader reader(data, size);
+    Header h;
+    transfer_header(reader, h);
+    if (!reader.good() || h.magic != magic || h.version != version) {
+        return false;
+    }
+
+    Body b = {};
+    qrsdata progress;
+    transfer_body(reader, h, b);
+    const std::size_t progressStart = reader.position();
+    transfer_progress(reader, progress);
+    if (!reader.good() || !reader.atEnd()) {
+        return false;
+    }
+
+    if (q->pracdata ||
+        h.modeFlags != q->mode_flags ||
+        h.modeType != q->mode_type ||
+        h.randomizerType != q->randomizer_type ||
+        h.fieldW != field.getWidth() ||
+        h.fieldH != field.getHeight() ||
+        h.numOlds != p->num_olds ||
+        h.randomizerSize != randomizer_state_size(q->randomizer)) {
+        return false;
+    }
+
+    // a recording continues in the game's own replay; playback needs the same replay loaded
+    if ((h.flags & SNAPSHOT_RECORDING) && q->playback) {
+        return false;
+    }
+    if ((h.flags & SNAPSHOT_PLAYBACK) && (!q->replay || q->recording || q->replay->pinputs.size() != b.replayLen)) {
+        return false;
+    }
+
+    auto valid = [](const PieceRef& piece) {
+        return IS_QRS_PIECE(piece.id);
+    };
+    if (((h.flags & SNAPSHOT_HAS_DEF) && !valid(b.def)) || ((h.flags & SNAPSHOT_HAS_HOLD) && !valid(b.hold))) {
+        return false;
+    }
+    for (const PieceRef& preview : b.previews) {
+        if (!valid(preview)) {
+            return false;
+        }
+    }
+    if (b.speeds >= 0 && !qs_speeds_from_index(b.speeds)) {
+        return false;
+    }
+
+    g.frame_counter = b.frameCounter;
+    auto cell = b.cells.begin();
+    for (std::size_t y = 0u; y < h.fieldH; y++) {
+        for (std::size_t x = 0u; x < h.fieldW; x++) {
+            field.cell(static_cast<int>(x), static_cast<int>(y)) = *cell++;
+        }
+    }
+
+    auto piece = [q](const PieceRef& ref) {
+        PieceDefinition* def = new PieceDefinition(q->piecepool[ref.id]);
+        def->flags = ref.flags;
+        return def;
+    };
+
+    delete p->def;
+    p->def = (h.flags & SNAPSHOT_HAS_DEF) ? piece(b.def) : nullptr;
+    p->state = b.state;
+    p->x = b.x;
+    p->y = b.y;
+    p->orient = b.orient;
+    p->speeds = qs_speeds_from_index(b.speeds);
+    std::copy(b.oldXs.begin(), b.oldXs.end(), p->old_xs);
+    std::copy(b.oldYs.begin(), b.oldYs.end(), p->old_ys);
+    *q->p1counters = b.counters;
+
+    delete q->hold;
+    q->hold = (h.flags & SNAPSHOT_HAS_HOLD) ? piece(b.hold) : nullptr;
+    q->previews.clear();
+    for (const PieceRef& ref : b.previews) {
+        q->previews.push_back(q->piecepool[ref.id]);
+        q->previews.back().flags = ref.flags;
+    }
+
+    q->timer.time = b.time;
+    q->randomizer_seed = b.randomizerSeed;
+    randomizer_load_state(q->randomizer, b.randomizer.data());
+
+    if (h.flags & SNAPSHOT_RECORDING) {
+        if (!q->replay) {
+            q->replay = new struct replay();
+        }
+        q->replay->pinputs.clear();
+        q->replay->mode = q->mode_type;
+        q->replay->mode_flags = q->mode_flags;
+        q->replay->seed = b.replaySeed;
+        q->replay->grade = NO_GRADE;
+        q->replay->time = 0;
+        q->replay->starting_level = b.replayStartingLevel;
+        q->replay->ending_level = 0;
+        q->replay->date = b.replayDate;
+        for (const std::uint8_t input : b.replayInputs) {
+            q->replay->pinputs.push_back({ input });
+        }
+        q->recording = true;
+    }
+    else if (q->recording) {
+        // saved before recording started; it starts again when the game gets there
+        delete q->replay;
+        q->replay = nullptr;
+        q->recording = false;
+    }
+    q->playback = (h.flags & SNAPSHOT_PLAYBACK) != 0u;
+
+    // the progress fields were only read to check them; read them again, into the game
+    Reader progressReader(data + progressStart, size - progressStart);
+    transfer_progress(progressReader, *q);
+
+    cs.keys = b.keys;
+    cs.prev_keys = b.prevKeys;
+    cs.hold_dir = b.holdDir;
+    cs.hold_time = b.holdTime;
+
+    qs_sync_music(&g);
+
+    return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "Game.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct CoreState;
+
+namespace Shiro {
+    /**
+     * Binary snapshots of a QRS game in progress, for suspending and resuming
+     * a game, recovering after a crash, and replay seeking.
+     *
+     * A snapshot is a header followed by the game's mutable state, every
+     * field a fixed-width little-endian integer in a fixed order. The header
+     * holds the format version, the mode the game was created with, and the
+     * length of every variable-length part, so a snapshot is checked in full
+     * before anything is restored.
+     *
+     * Only state that changes during play is stored. A snapshot is restored
+     * into a game created with the same mode flags, which provides the rest
+     * (piece pool, speed curves, garbage, the replay being played back).
+     * Practice games aren't supported.
+     */
+    namespace GameSnapshot {
+        constexpr std::uint32_t magic = 0x53475153u; // "SQGS" in a little-endian dump
+        constexpr std::uint16_t version = 1u;
+
+        /**
+         * Replaces `out` with a snapshot of `g` and the input state of `cs`
+         * it depends on. Returns false, leaving `out` empty, for games that
+         * can't be snapshotted.
+         */
+        bool save(const CoreState& cs, const game_t& g, std::vector<std::uint8_t>& out);
+
+        /**
+         * Puts `g` and `cs` back in the state a snapshot was saved in.
+         * Returns false and changes nothing if the snapshot is malformed, is
+         * from another version, or was saved from an incompatible game.
+         */
+        bool restore(CoreState& cs, game_t& g, const std::uint8_t* data, std::size_t size);
+    }
+}
@@ -1,11 +1,16 @@
 #include "Grid.h"
+#include <algorithm>
+#include <numeric>
 
 Shiro::Grid::Grid() : width(0), height(0) {}
 
 Shiro::Grid::Grid(std::size_t width, std::size_t height) :
     width(width),
     height(height),
-    cells(std::vector<std::vector<int>>(height, std::vector<int>(width, 0))) {}
+    cells(width * height, 0),
+    rows(height) {
+    std::iota(this->rows.begin(), this->rows.end(), std::size_t(0));
+}
 
 Shiro::Grid::Grid(const Grid& srcGrid, const GridRect& srcRect) {
     int startX = srcRect.x;
@@ -31,39 +36,34 @@ Shiro::Grid::Grid(const Grid& srcGrid, const GridRect& srcRect) {
         return;
     }
 
-    this->width = (long)endX - startX;
-    this->height = (long)endY - startY;
-    this->cells = std::vector<std::vector<int>>(this->height, std::vector<int>(this->width));
+    *this = Grid((long)endX - startX, (long)endY - startY);
     for (std::size_t y = 0; y < this->height; y++) {
-        for (std::size_t x = 0; x < this->width; x++) {
-            this->cells[y][x] = srcGrid.cells[startY + y][startX + x];
-        }
+        std::copy_n(srcGrid.rowCells(startY + y) + startX, this->width, rowCells(y));
     }
 }
 
 void Shiro::Grid::setWidth(std::size_t width) {
-    this->width = width;
-    for (auto& row : this->cells) {
-        row.resize(this->width, 0);
-    }
+    resize(width, this->height);
 }
 
 void Shiro::Grid::setHeight(std::size_t height) {
-    this->height = height;
-    this->cells.resize(height, std::vector<int>(this->width, 0));
+    resize(this->width, height);
 }
 
 void Shiro::Grid::resize(std::size_t width, std::size_t height) {
-    this->width = width;
-    this->height = height;
-    for (auto& row : cells) {
-        row.resize(this->width, 0);
+    Grid resized(width, height);
+    const std::size_t copyWidth = std::min(width, this->width);
+    const std::size_t copyHeight = std::min(height, this->height);
+    for (std::size_t y = 0; y < copyHeight; y++) {
+        std::copy_n(rowCells(y), copyWidth, resized.rowCells(y));
     }
-    cells.resize(this->height, std::vector<int>(this->width, 0));
+    *this = std::move(resized);
 }
 
 int& Shiro::Grid::cell(int x, int y) {
-    return cells[y][x];
+    // The caller may write through the reference.
+    this->occupancyDirty = true;
+    return rowCells(y)[x];
 }
 
 int Shiro::Grid::setCell(int x, int y, int value) {
@@ -74,7 +74,8 @@ int Shiro::Grid::setCell(int x, int y, int value) {
         return 1;
     }
 
-    this->cells[y][x] = value;
+    rowCells(y)[x] = value;
+    this->occupancyDirty = true;
     return 0;
 }
 
@@ -86,7 +87,8 @@ int Shiro::Grid::xorCell(int x, int y, int value) {
         return 1;
     }
 
-    cells[y][x] ^= value;
+    rowCells(y)[x] ^= value;
+    this->occupancyDirty = true;
     return 0;
 }
 
@@ -118,11 +120,15 @@ void Shiro::Grid::fill(const GridRect& rect, int value) {
         endY = static_cast<int>(this->height);
     }
 
+    if (startX >= endX) {
+        return;
+    }
+
+    // Each row of the rect is contiguous, so the fill vectorizes.
     for (int y = startY; y < endY; y++) {
-        for (int x = startX; x < endX; x++) {
-            this->cells[y][x] = value;
-        }
+        std::fill_n(rowCells(y) + startX, endX - startX, value);
     }
+    this->occupancyDirty = true;
 }
 
 void Shiro::Grid::copyRect(const Grid& srcGrid, const GridRect& srcRect, const GridRect& dstRect) {
@@ -182,11 +188,22 @@ void Shiro::Grid::copyRect(const Grid& srcGrid, const GridRect& srcRect, const G
         srcEndY = srcStartY + (dstEndY - dstStartY);
     }
 
-    for (std::size_t y = 0; y < srcRect.height; y++) {
-        for (std::size_t x = 0; x < srcRect.width; x++) {
-            this->cells[dstStartY + y][dstStartX + x] = srcGrid.cells[srcStartY + y][srcStartX + x];
-        }
+    if (srcStartX >= srcEndX) {
+        return;
     }
+
+    // Copy row spans of the clipped rect; copying a grid onto itself goes
+    // through a temporary so overlapping rects work.
+    const Grid* src = &srcGrid;
+    Grid srcCopy;
+    if (src == this) {
+        srcCopy = srcGrid;
+        src = &srcCopy;
+    }
+    for (int y = 0; y < srcEndY - srcStartY; y++) {
+        std::copy_n(src->rowCells(srcStartY + y) + srcStartX, srcEndX - srcStartX, rowCells(dstStartY + y) + dstStartX);
+    }
+    this->occupancyDirty = true;
 }
 
 void Shiro::Grid::copyRow(std::size_t srcRow, std::size_t dstRow) {
@@ -196,13 +213,16 @@ void Shiro::Grid::copyRow(std::size_t srcRow, std::size_t dstRow) {
 }
 
 void Shiro::Grid::copyRow(const Grid& srcGrid, std::size_t srcRow, std::size_t dstRow) {
-    for (std::size_t x = 0; x < this->width; x++) {
-        if (x < srcGrid.width) {
-            this->cells[dstRow][x] = srcGrid.cells[srcRow][x];
-        }
-        else {
-            this->cells[dstRow][x] = 0;
-        }
+    const std::size_t copyWidth = std::min(this->width, srcGrid.width);
+    std::copy_n(srcGrid.rowCells(srcRow), copyWidth, rowCells(dstRow));
+    std::fill_n(rowCells(dstRow) + copyWidth, this->width - copyWidth, 0);
+    this->occupancyDirty = true;
+}
+
+void Shiro::Grid::swapRows(std::size_t row1, std::size_t row2) {
+    std::swap(this->rows[row1], this->rows[row2]);
+    if (!this->occupancyDirty) {
+        std::swap(this->occupancyRows[row1], this->occupancyRows[row2]);
     }
 }
 
@@ -218,15 +238,73 @@ int Shiro::Grid::getCell(std::size_t x, std::size_t y) const {
     if (x >= this->width || y >= this->height) {
         return GRID_OOB;
     }
-    return this->cells[y][x];
+    return rowCells(y)[x];
 }
 
 std::size_t Shiro::Grid::cellsFilled() const {
-    std::size_t numCellsFilled = 0;
-    for (auto&& row : cells) {
-        for (auto&& cell : row) {
-            numCellsFilled += cell != 0;
+    return this->cells.size() - static_cast<std::size_t>(std::count(this->cells.begin(), this->cells.end(), 0));
+}
+
+std::uint64_t Shiro::Grid::occupancy(int y) const {
+    if (y < 0 || y >= int(this->height)) {
+        return ~UINT64_C(0);
+    }
+    if (this->occupancyDirty) {
+        updateOccupancy();
+    }
+    return this->occupancyRows[y];
+}
+
+void Shiro::Grid::updateOccupancy() const {
+    this->occupancyRows.assign(this->height, ~UINT64_C(0));
+    this->occupancyDirty = false;
+    if (this->width > occupancyMaxWidth) {
+        return;
+    }
+
+    const std::uint64_t walls = ~(((UINT64_C(1) << this->width) - 1u) << occupancyPadding);
+    for (std::size_t y = 0; y < this->height; y++) {
+        const int* cells = rowCells(y);
+        std::uint64_t row = walls;
+        for (std::size_t x = 0; x < this->width; x++) {
+            row |= static_cast<std::uint64_t>(cells[x] != 0) << (x + occupancyPadding);
         }
+        this->occupancyRows[y] = row;
     }
-    return numCellsFilled;
+}
+
+bool Shiro::Grid::collides(const Grid& piece, int x, int y, std::pair<int, int>& pos) const {
+    const int shift = x + occupancyPadding;
+    if (
+        this->width > occupancyMaxWidth ||
+        piece.width > occupancyMaxWidth ||
+        shift < 0 ||
+        shift > 63 - int(piece.width)
+    ) {
+        for (int pieceY = 0, gridY = y; pieceY < int(piece.height); pieceY++, gridY++) {
+            for (int pieceX = 0, gridX = x; pieceX < int(piece.width); pieceX++, gridX++) {
+                if (piece.getCell(pieceX, pieceY) && this->getCell(gridX, gridY)) {
+                    pos = std::pair<int, int>(pieceX, pieceY);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    const std::uint64_t pieceColumns = (UINT64_C(1) << piece.width) - 1u;
+    for (int pieceY = 0; pieceY < int(piece.height); pieceY++) {
+        const std::uint64_t pieceRow = (piece.occupancy(pieceY) >> occupancyPadding) & pieceColumns;
+        const std::uint64_t overlap = pieceRow & (occupancy(y + pieceY) >> shift);
+        if (overlap) {
+            int pieceX = 0;
+            while (!(overlap & (UINT64_C(1) << pieceX))) {
+                pieceX++;
+            }
+            pos = std::pair<int, int>(pieceX, pieceY);
+            return true;
+        }
+    }
+
+    return false;
 }
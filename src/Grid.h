@@ -1,11 +1,46 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
 #include <vector>
 
 #define GRID_OOB 8128
 
 namespace Shiro {
+    /**
+     * Allocator for storage that should start on its own cache line.
+     */
+    template<typename T, std::size_t alignment>
+    struct AlignedAllocator {
+        using value_type = T;
+
+        template<typename U>
+        struct rebind {
+            using other = AlignedAllocator<U, alignment>;
+        };
+
+        AlignedAllocator() = default;
+
+        template<typename U>
+        AlignedAllocator(const AlignedAllocator<U, alignment>&) {}
+
+        T* allocate(std::size_t n) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignment)));
+        }
+
+        void deallocate(T* p, std::size_t) {
+            ::operator delete(p, std::align_val_t(alignment));
+        }
+
+        template<typename U>
+        bool operator==(const AlignedAllocator<U, alignment>&) const { return true; }
+        template<typename U>
+        bool operator!=(const AlignedAllocator<U, alignment>&) const { return false; }
+    };
+
     struct GridRect {
         const int x;
         const int y;
@@ -20,12 +55,10 @@ namespace Shiro {
         Grid(const Grid& srcGrid, const GridRect& srcRect);
 
         template<std::size_t polyominoWidth, std::size_t polyominoHeight>
-        Grid(const std::array<std::array<bool, polyominoWidth>, polyominoHeight>& polyomino) : width(polyominoWidth), height(polyominoHeight) {
-            cells.resize(polyominoHeight);
+        Grid(const std::array<std::array<bool, polyominoWidth>, polyominoHeight>& polyomino) : Grid(polyominoWidth, polyominoHeight) {
             for (auto y = 0u; y < polyominoHeight; y++) {
-                cells[y].resize(polyominoWidth);
                 for (auto x = 0u; x < polyominoWidth; x++) {
-                    cells[y][x] = polyomino[y][x];
+                    cells[y * polyominoWidth + x] = polyomino[y][x];
                 }
             }
         }
@@ -44,6 +77,13 @@ namespace Shiro {
         void copyRow(std::size_t srcRow, std::size_t dstRow);
         void copyRow(const Grid& srcGrid, std::size_t srcRow, std::size_t dstRow);
 
+        /**
+         * Exchanges two rows in constant time, by swapping their entries in
+         * the row index table; no cells are copied. Line clears are done as a
+         * sequence of these.
+         */
+        void swapRows(std::size_t row1, std::size_t row2);
+
         std::size_t getWidth() const;
         std::size_t getHeight() const;
 
@@ -51,9 +91,51 @@ namespace Shiro {
 
         std::size_t cellsFilled() const;
 
+        /**
+         * Occupancy bitboard of row y. Bit (x + occupancyPadding) is set if
+         * the cell at (x, y) is nonzero; like getCell's GRID_OOB, columns
+         * outside the grid are always set, and rows outside the grid are all
+         * set. Only available for grids up to occupancyMaxWidth wide.
+         *
+         * The bitboard is rebuilt lazily after the grid is modified, so
+         * repeated queries against an unchanged grid are cheap.
+         */
+        std::uint64_t occupancy(int y) const;
+
+        /**
+         * Returns true if any nonzero cell of `piece`, with its top-left cell
+         * placed at (x, y) in this grid, overlaps a nonzero or out-of-bounds
+         * cell of this grid. When there's a collision, `pos` is set to the
+         * first colliding cell of `piece` in row-major order.
+         */
+        bool collides(const Grid& piece, int x, int y, std::pair<int, int>& pos) const;
+
+        static constexpr int occupancyPadding = 8;
+        static constexpr std::size_t occupancyMaxWidth = 64u - 2u * occupancyPadding;
+
     private:
+        static constexpr std::size_t cacheLineSize = 64u;
+
+        void updateOccupancy() const;
+
+        int* rowCells(std::size_t y) {
+            return this->cells.data() + this->rows[y] * this->width;
+        }
+
+        const int* rowCells(std::size_t y) const {
+            return this->cells.data() + this->rows[y] * this->width;
+        }
+
         std::size_t width;
         std::size_t height;
-        std::vector<std::vector<int>> cells; // cells[row #][column #]
+
+        // All cells are in one contiguous buffer, one row after another in
+        // storage order; rows[row #] is the storage index of a row, so
+        // reordering rows only permutes the table.
+        std::vector<int, AlignedAllocator<int, cacheLineSize>> cells;
+        std::vector<std::size_t> rows;
+
+        mutable bool occupancyDirty = true;
+        mutable std::vector<std::uint64_t> occupancyRows;
     };
 }
@@ -0,0 +1,69 @@
+#include "Headless.h"
+#include "CoreState.h"
+#include "game_qs.h"
+#include "QRS0.h"
+#include <cstdlib>
+
+bool headless_game_frame(CoreState *cs, game_t *g, struct packed_input input)
+{
+    cs->prev_keys_raw = cs->keys_raw;
+    cs->prev_keys = cs->keys;
+
+    unpack_input(input, &cs->keys_raw);
+    cs->keys = cs->keys_raw;
+
+    cs->handle_replay_input();
+
+    cs->update_input_repeat();
+    cs->update_pressed();
+
+    if(!g->update(true))
+        return false;
+
+    g->frame_counter++;
+    return true;
+}
+
+int headless_simulate_replay(CoreState *cs, const struct replay *r, Shiro::HeadlessResult *out_result, unsigned long max_frames)
+{
+    game_t *g = qs_game_create(cs, r->starting_level, r->mode_flags, NO_REPLAY);
+    if(!g)
+        return 1;
+
+    // run with no presentation at all
+    g->sink = nullptr;
+
+    qrsdata *q = (qrsdata *)g->data;
+    q->replay = new struct replay(*r);
+
+    game_t *prev_game = cs->p1game;
+    cs->p1game = g;
+    g->init(g);
+
+    const struct packed_input none = { 0 };
+    unsigned long frames = 0;
+    bool started = false;
+    while(frames < max_frames)
+    {
+        if(!headless_game_frame(cs, g, none))
+            break;
+
+        frames++;
+
+        if(q->playback)
+            started = true;
+        else if(started)
+            break;
+    }
+
+    out_result->frames = frames;
+    out_result->grade = q->grade;
+    out_result->ending_level = q->level;
+    out_result->time = q->timer;
+
+    g->quit(g);
+    free(g);
+    cs->p1game = prev_game;
+
+    return 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Game.h"
+#include "replay.h"
+#include <cstddef>
+#include <cstdint>
+
+struct CoreState;
+
+namespace Shiro {
+    /**
+     * Outcome of a headless simulation, in the same units as the
+     * corresponding fields of struct replay.
+     */
+    struct HeadlessResult {
+        unsigned long frames;
+        int grade;
+        int ending_level;
+        uint64_t time;
+    };
+}
+
+/**
+ * Steps one game frame exactly the way CoreState::run does, but without
+ * reading input devices, rendering or drawing. The keys for the frame come
+ * from `input` (or from the game's replay, if it's playing one back). Returns
+ * false when the game asks to quit, like game::update.
+ */
+bool headless_game_frame(CoreState *cs, game_t *g, struct packed_input input);
+
+/**
+ * Re-simulates a replay with no window, renderer or mixer. The game has no
+ * PresentationSink, so it runs as fast as the CPU allows. `cs` only needs to
+ * be constructed; CoreState::init doesn't have to be called. Simulation stops
+ * when the replay's playback ends, or after `max_frames` frames.
+ *
+ * Returns 0 on success, nonzero if the game couldn't be created.
+ */
+int headless_simulate_replay(CoreState *cs, const struct replay *r, Shiro::HeadlessResult *out_result, unsigned long max_frames);
@@ -93,4 +93,18 @@ void Shiro::KeyBindings::write(PDINI::INI& ini) const {
         ini.set(sectionName, keyBindingName, std::string(SDL_GetKeyName(**keycode)));
         ++keycode;
     }
-}
\ No newline at end of file
+}
+
+bool Shiro::KeyBindings::binds(SDL_Keycode key) const {
+    return
+        key == left ||
+        key == right ||
+        key == up ||
+        key == down ||
+        key == start ||
+        key == a ||
+        key == b ||
+        key == c ||
+        key == d ||
+        key == escape;
+}
@@ -11,6 +11,9 @@ namespace Shiro {
         void read(PDINI::INI& ini);
         void write(PDINI::INI& ini) const;
 
+        // true if any of the bindings is `key`
+        bool binds(SDL_Keycode key) const;
+
         SDL_Keycode left;
         SDL_Keycode right;
         SDL_Keycode up;
@@ -6,11 +6,29 @@
  */
 #include "CoreState.h"
 #include "Main/Startup.h"
+#include "RandomizerAnalysis.h"
+#include "RandomizerBenchmark.h"
+#include "RecordListBenchmark.h"
+#include "ReplayVerifier.h"
 #include <cstdlib>
+#include <string>
 
 int main(int argc, char* argv[]) {
     int returnCode;
 
+    if (argc >= 2 && std::string(argv[1]) == "--benchmark-randomizer") {
+        return randomizer_benchmark(argc - 2, argv + 2);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--analyze-randomizer") {
+        return randomizer_analysis(argc - 2, argv + 2);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--benchmark-records") {
+        return record_list_benchmark(argc - 2, argv + 2);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--verify-replays") {
+        return replay_verification(argc - 2, argv + 2);
+    }
+
     Shiro::Settings settings;
     if (settings.init(argc, argv)) {
         Shiro::Startup(settings);
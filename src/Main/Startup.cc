@@ -1,6 +1,5 @@
 #include "Main/Startup.h"
 #include "Version.h"
-#include "random.h"
 #include "SDL.h"
 #include "SDL_image.h"
 #include "SDL_mixer.h"
@@ -55,7 +54,6 @@ void Shiro::Startup(const Shiro::Settings& settings) {
     }
     Mix_AllocateChannels(32);
 
-    g123_seeds_init();
     std::srand((unsigned int)std::time(0));
 
     std::atexit(Shiro::Quit);
@@ -4,4 +4,5 @@ Shiro::PieceDefinition::PieceDefinition() :
     qrsID(0),
     flags(PDNONE),
     anchorX(0),
-    anchorY(0) {}
\ No newline at end of file
+    anchorY(0),
+    rotationMasks(nullptr) {}
\ No newline at end of file
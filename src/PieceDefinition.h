@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Grid.h"
+#include "RotationTables.h"
 #include <bitset>
 #include <array>
 #include <cstdint>
@@ -34,5 +35,9 @@ namespace Shiro {
         int anchorX;
         int anchorY;
         std::array<Grid, 4> rotationTable;
+
+        // Shared, immutable masks of rotationTable, or null if rotationTable
+        // doesn't match any built-in piece (e.g. it was modified).
+        const std::array<RotationMask, 4>* rotationMasks;
     };
 }
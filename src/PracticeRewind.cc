@@ -0,0 +1,201 @@
+#include "PracticeRewind.h"
+#include "random.h"
+#include <utility>
+
+Shiro::PracticeRewind::PracticeRewind(std::size_t budget) :
+    budget(budget),
+    used(0u) {}
+
+void Shiro::PracticeRewind::clear() {
+    points.clear();
+    used = 0u;
+}
+
+std::size_t Shiro::PracticeRewind::size() const {
+    return points.size();
+}
+
+std::size_t Shiro::PracticeRewind::memoryUsed() const {
+    return used;
+}
+
+std::size_t Shiro::PracticeRewind::footprint(const Point& point) {
+    return sizeof(Point) +
+        point.undo.capacity() * sizeof(CellChange) +
+        point.randomizerState.capacity() +
+        point.previews.capacity() * sizeof(PieceRef);
+}
+
+void Shiro::PracticeRewind::evict() {
+    // the newest point is always kept, so the current piece can be restarted
+    while (used > budget && points.size() > 1u) {
+        used -= footprint(points.front());
+        points.pop_front();
+    }
+}
+
+void Shiro::PracticeRewind::record(game_t& g) {
+    qrsdata *q = static_cast<qrsdata *>(g.data);
+    const Grid& current = *g.field;
+
+    if (current.getWidth() != field.getWidth() || current.getHeight() != field.getHeight()) {
+        clear();
+    }
+
+    if (!points.empty()) {
+        // the newest point's placement is done now, so its delta is known
+        Point& last = points.back();
+        used -= footprint(last);
+        const std::size_t width = field.getWidth();
+        for (std::size_t y = 0u; y < field.getHeight(); y++) {
+            for (std::size_t x = 0u; x < width; x++) {
+                const int before = field.getCell(x, y);
+                if (before != current.getCell(x, y)) {
+                    last.undo.push_back({ static_cast<std::uint16_t>(y * width + x), before });
+                }
+            }
+        }
+        last.undo.shrink_to_fit();
+        used += footprint(last);
+    }
+    field = current;
+
+    Point point;
+
+    point.randomizerState.resize(randomizer_state_size(q->randomizer));
+    randomizer_save_state(q->randomizer, point.randomizerState.data());
+
+    point.current = { q->p1->def->qrsID, q->p1->def->flags };
+    if (q->hold) {
+        point.hold = { q->hold->qrsID, q->hold->flags };
+    }
+    else {
+        point.hold = { PIECE_ID_INVALID, PDNONE };
+    }
+    point.previews.reserve(q->previews.size());
+    for (const auto& preview : q->previews) {
+        point.previews.push_back({ preview.qrsID, preview.flags });
+    }
+
+    point.playerState = q->p1->state;
+    point.x = q->p1->x;
+    point.y = q->p1->y;
+    point.orient = q->p1->orient;
+    point.counters = *q->p1counters;
+
+    point.time = q->timer.time;
+    point.level = q->level;
+    point.section = q->section;
+    point.score = q->score;
+    point.stateFlags = q->state_flags;
+    point.histIndex = q->pracdata ? q->pracdata->hist_index : 0;
+    point.pieceSeqIndex = q->piece_seq_index;
+    point.garbageRowIndex = q->garbage_row_index;
+    point.garbageCounter = q->garbage_counter;
+    point.levelstopTime = q->levelstop_time;
+    point.lastclear = q->lastclear;
+    point.combo = q->combo;
+    point.comboSimple = q->combo_simple;
+    point.singles = q->singles;
+    point.doubles = q->doubles;
+    point.triples = q->triples;
+    point.tetrises = q->tetrises;
+    point.pentrises = q->pentrises;
+
+    used += footprint(point);
+    points.push_back(std::move(point));
+    evict();
+}
+
+bool Shiro::PracticeRewind::rewind(game_t& g, std::size_t pieces) {
+    if (pieces >= points.size()) {
+        return false;
+    }
+
+    qrsdata *q = static_cast<qrsdata *>(g.data);
+    qrs_player *p = q->p1;
+    const std::size_t target = points.size() - 1u - pieces;
+
+    // undo placements newest first, starting from the field as the newest
+    // piece spawned; whatever the current piece did hasn't been recorded
+    Grid& f = *g.field;
+    f = field;
+    const std::size_t width = f.getWidth();
+    while (points.size() - 1u > target) {
+        used -= footprint(points.back());
+        points.pop_back();
+        for (const CellChange& change : points.back().undo) {
+            f.cell(static_cast<int>(change.index % width), static_cast<int>(change.index / width)) = change.value;
+        }
+    }
+    Point& point = points.back();
+    used -= footprint(point);
+    point.undo.clear();
+    point.undo.shrink_to_fit();
+    used += footprint(point);
+    field = f;
+
+    randomizer_load_state(q->randomizer, point.randomizerState.data());
+
+    auto piece = [q](const PieceRef& ref) {
+        PieceDefinition* def = new PieceDefinition(q->piecepool[ref.id]);
+        def->flags = ref.flags;
+        return def;
+    };
+
+    delete p->def;
+    p->def = piece(point.current);
+    q->cur_piece_qrs_id = point.current.id;
+
+    delete q->hold;
+    q->hold = point.hold.id != PIECE_ID_INVALID ? piece(point.hold) : nullptr;
+
+    q->previews.clear();
+    for (const PieceRef& ref : point.previews) {
+        q->previews.push_back(q->piecepool[ref.id]);
+        q->previews.back().flags = ref.flags;
+    }
+
+    p->state = point.playerState;
+    p->x = point.x;
+    p->y = point.y;
+    p->orient = point.orient;
+    for (int i = 0; i < p->num_olds; i++) {
+        p->old_xs[i] = p->x;
+        p->old_ys[i] = p->y;
+    }
+    *q->p1counters = point.counters;
+
+    q->timer.time = point.time;
+    q->level = point.level;
+    q->section = point.section;
+    q->score = point.score;
+    q->state_flags = point.stateFlags;
+    if (q->pracdata) {
+        q->pracdata->hist_index = point.histIndex;
+    }
+    q->piece_seq_index = point.pieceSeqIndex;
+    q->garbage_row_index = point.garbageRowIndex;
+    q->garbage_counter = point.garbageCounter;
+    q->levelstop_time = point.levelstopTime;
+    q->lastclear = point.lastclear;
+    q->combo = point.combo;
+    q->combo_simple = point.comboSimple;
+    q->singles = point.singles;
+    q->doubles = point.doubles;
+    q->triples = point.triples;
+    q->tetrises = point.tetrises;
+    q->pentrises = point.pentrises;
+
+    // per-piece values that dealing a piece resets
+    q->lock_on_rotate = 0;
+    q->lock_held = false;
+    q->soft_drop_counter = 0;
+    q->sonic_drop_height = 0;
+    q->active_piece_time = 0;
+    q->placement_speed = 0;
+    q->lvlinc = 0;
+    q->stack_anim_counter = 0;
+
+    return true;
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "Game.h"
+#include "Grid.h"
+#include "PieceDefinition.h"
+#include "QRS0.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace Shiro {
+    /**
+     * Piece-by-piece rewind history for the practice tool. A rewind point is
+     * recorded each time a piece is dealt. Instead of a copy of the field,
+     * each point keeps only the cells the placement after it changed, plus
+     * the randomizer state, counters and piece queue. Stepping back n pieces
+     * undoes n of those small deltas, with no re-simulation.
+     *
+     * Points are kept in a ring; once their total size goes over the memory
+     * budget, the oldest are dropped.
+     */
+    class PracticeRewind {
+    public:
+        explicit PracticeRewind(std::size_t budget);
+
+        /**
+         * Forgets every rewind point, for when a new practice game starts.
+         */
+        void clear();
+
+        /**
+         * Records a rewind point for the piece that was just dealt.
+         */
+        void record(game_t& g);
+
+        /**
+         * Puts the game back to when the piece dealt `pieces` placements ago
+         * spawned; 0 restarts the current piece. Points after it are
+         * discarded. Returns false if the history doesn't go back that far,
+         * in which case nothing is changed.
+         */
+        bool rewind(game_t& g, std::size_t pieces);
+
+        std::size_t size() const;
+        std::size_t memoryUsed() const;
+
+    private:
+        struct CellChange {
+            std::uint16_t index; // y * field width + x
+            int value;
+        };
+
+        struct PieceRef {
+            piece_id id;
+            PieceDefinitionFlag flags;
+        };
+
+        struct Point {
+            // the cells the next placement changed, with their values before
+            // it; empty for the newest point, whose piece is still in play
+            std::vector<CellChange> undo;
+            std::vector<std::uint8_t> randomizerState;
+
+            PieceRef current;
+            PieceRef hold;
+            std::vector<PieceRef> previews;
+
+            unsigned playerState;
+            int x;
+            int y;
+            int orient;
+            QRS_Counters counters;
+
+            std::uint64_t time;
+            unsigned level;
+            int section;
+            int score;
+            unsigned stateFlags;
+            int histIndex;
+            int pieceSeqIndex;
+            int garbageRowIndex;
+            int garbageCounter;
+            int levelstopTime;
+            int lastclear;
+            int combo;
+            int comboSimple;
+            int singles;
+            int doubles;
+            int triples;
+            int tetrises;
+            int pentrises;
+        };
+
+        static std::size_t footprint(const Point& point);
+        void evict();
+
+        std::deque<Point> points;
+        // the field when the newest point was recorded
+        Grid field;
+        std::size_t budget;
+        std::size_t used;
+    };
+}
@@ -0,0 +1,77 @@
+#include "PresentationSink.h"
+#include "CoreState.h"
+#include "Asset/Font.h"
+#include "Asset/Image.h"
+#include "Asset/Music.h"
+#include "Asset/Sfx.h"
+#include "QRS0.h"
+#include "Video/MessageEntity.h"
+#include "gfx_qs.h"
+#include "SDL_mixer.h"
+
+Shiro::CoreStateSink::CoreStateSink(CoreState& cs) :
+    cs(cs) {}
+
+void Shiro::CoreStateSink::playSfx(const std::filesystem::path& name) {
+    SfxAsset::get(cs.assetMgr, name).play(cs.settings);
+}
+
+void Shiro::CoreStateSink::playSfx(const std::filesystem::path& name, std::size_t i) {
+    SfxAsset::get(cs.assetMgr, name, i).play(cs.settings);
+}
+
+void Shiro::CoreStateSink::playMusic(const std::filesystem::path& tracks, int track) {
+    if (track == -1) {
+        Mix_HaltMusic();
+    }
+    else {
+        MusicAsset::get(cs.assetMgr, tracks, track).play(cs.settings);
+    }
+}
+
+void Shiro::CoreStateSink::haltMusic() {
+    Mix_HaltMusic();
+}
+
+void Shiro::CoreStateSink::pushMessage(
+    const std::string& text,
+    const int& x,
+    const int& y,
+    const int offsetX,
+    const int offsetY,
+    const float scale,
+    const std::uint32_t color,
+    const std::size_t numFrames
+) {
+    CoreState* const cs = &this->cs;
+    const auto gameIsInactive = [cs]() {
+        if (cs->p1game == nullptr || cs->p1game->data == nullptr) {
+            return true;
+        }
+
+        const qrsdata* const q = static_cast<qrsdata*>(cs->p1game->data);
+        return q->pracdata != nullptr && q->pracdata->paused == QRS_FIELD_EDIT;
+    };
+
+    MessageEntity::push(cs->gfx,
+        FontAsset::get(cs->assetMgr, "fixedsys"),
+        text,
+        x,
+        y,
+        offsetX,
+        offsetY,
+        scale,
+        color,
+        numFrames,
+        GfxLayer::messages,
+        gameIsInactive
+    );
+}
+
+void Shiro::CoreStateSink::lineClear(game_t *g, int row) {
+    gfx_qs_lineclear(g, row);
+}
+
+void Shiro::CoreStateSink::transitionBackground(std::size_t bgNumber) {
+    cs.bg.transition(ImageAsset::get(cs.assetMgr, "bg", bgNumber));
+}
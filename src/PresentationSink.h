@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+struct CoreState;
+typedef struct game game_t;
+
+namespace Shiro {
+    /**
+     * Receives the audiovisual side effects of a running game: sound effects,
+     * music, on-field messages, line clear animations and background
+     * transitions. Game logic never depends on what a sink does, so a game
+     * with no sink (game::sink == nullptr) simulates exactly the same as one
+     * attached to a window and mixer, which is what lets replays be
+     * re-simulated headless.
+     */
+    class PresentationSink {
+    public:
+        virtual ~PresentationSink() {}
+
+        virtual void playSfx(const std::filesystem::path& name) = 0;
+        virtual void playSfx(const std::filesystem::path& name, std::size_t i) = 0;
+
+        /**
+         * Plays track number `track` from the directory `tracks`; a track of
+         * -1 halts the music.
+         */
+        virtual void playMusic(const std::filesystem::path& tracks, int track) = 0;
+        virtual void haltMusic() = 0;
+
+        /**
+         * Pushes a message drawn relative to the position (x, y). The
+         * position is referenced, not copied, so messages follow the field if
+         * it moves.
+         */
+        virtual void pushMessage(
+            const std::string& text,
+            const int& x,
+            const int& y,
+            const int offsetX,
+            const int offsetY,
+            const float scale,
+            const std::uint32_t color,
+            const std::size_t numFrames
+        ) = 0;
+
+        virtual void lineClear(game_t *g, int row) = 0;
+        virtual void transitionBackground(std::size_t bgNumber) = 0;
+    };
+
+    /**
+     * The sink used by the normal, windowed game; forwards everything to the
+     * assets, Gfx and background owned by a CoreState.
+     */
+    class CoreStateSink : public PresentationSink {
+    public:
+        CoreStateSink() = delete;
+
+        CoreStateSink(CoreState& cs);
+
+        void playSfx(const std::filesystem::path& name) override;
+        void playSfx(const std::filesystem::path& name, std::size_t i) override;
+        void playMusic(const std::filesystem::path& tracks, int track) override;
+        void haltMusic() override;
+        void pushMessage(
+            const std::string& text,
+            const int& x,
+            const int& y,
+            const int offsetX,
+            const int offsetY,
+            const float scale,
+            const std::uint32_t color,
+            const std::size_t numFrames
+        ) override;
+        void lineClear(game_t *g, int row) override;
+        void transitionBackground(std::size_t bgNumber) override;
+
+    private:
+        CoreState& cs;
+    };
+}
@@ -1,5 +1,4 @@
 #include "CoreState.h"
-#include "Asset/Sfx.h"
 #include "game_menu.h" // questionable dependency - TODO look into these
 #include "game_qs.h"   // questionable dependency
 #include "GameType.h"
@@ -10,9 +9,11 @@
 #include "Grid.h"
 #include "Input/KeyFlags.h"
 #include "PieceDefinition.h"
+#include "PracticeRewind.h"
 #include "QRS0.h"
 #include "random.h"
 #include "replay.h"
+#include "ReplayKeyframes.h"
 #include "Timer.h"
 #include "RotationTables.h"
 #include "SDL.h"
@@ -22,6 +23,7 @@
 #include <string>
 #include <utility>
 #include <memory>
+#include <vector>
 const char *qrspiece_names[25] = {"I", "J", "L",  "X",  "S", "Z",       "N",  "G",  "U",  "T", "Fa", "Fb", "P",
                                   "Q", "W", "Ya", "Yb", "V", /**/ "I4", "T4", "J4", "L4", "O", "S4", "Z4"};
 
@@ -63,11 +65,9 @@ void qrsdata_destroy(qrsdata *q)
     free(q->p1);
     delete q->p1counters;
 
-    if(q->replay)
-    {
-        free(q->replay);
-    }
+    delete q->replay;
 
+    delete q->keyframes;
     delete q->hold;
 
     delete q;
@@ -76,11 +76,7 @@ void qrsdata_destroy(qrsdata *q)
 pracdata::pracdata() :
     game_type(Shiro::GameType::SIMULATE_QRS),
     field_w(0),
-    //long_history(nullptr),
-    usr_sequence(),
-    usr_seq_expand(),
-    usr_seq_len(0u),
-    usr_seq_expand_len(0u),
+    rewind(nullptr),
     field_edit_in_progress(false),
     palette_selection(0),
     field_selection(0),
@@ -98,14 +94,7 @@ pracdata::pracdata() :
     infinite_floorkicks(false),
     piece_subset(0),
     randomizer_seed(0l)
-{
-    for (int& item : usr_sequence) {
-        item = 0;
-    }
-    for (int& item : usr_seq_expand) {
-        item = 0;
-    }
-}
+{}
 
 void pracdata_destroy(pracdata *d)
 {
@@ -115,6 +104,8 @@ void pracdata_destroy(pracdata *d)
     if (d->usr_timings) {
         delete d->usr_timings;
     }
+
+    delete d->rewind;
 }
 
 pracdata *pracdata_cpy(pracdata *d)
@@ -125,21 +116,9 @@ pracdata *pracdata_cpy(pracdata *d)
     pracdata *cpy = (pracdata *)malloc(sizeof(pracdata));
     assert(cpy != nullptr);
 
-    for(std::size_t i = 0; i < d->usr_seq_len; i++)
-    {
-        cpy->usr_sequence[i] = d->usr_sequence[i];
-    }
+    cpy->usr_sequence = d->usr_sequence;
 
-    for(std::size_t i = 0; i < d->usr_seq_expand_len; i++)
-    {
-        cpy->usr_seq_expand[i] = d->usr_seq_expand[i];
-    }
-
-    cpy->usr_seq_len = d->usr_seq_len;
-    cpy->usr_seq_expand_len = d->usr_seq_expand_len;
-
-    cpy->usr_field_undo = d->usr_field_undo;
-    cpy->usr_field_redo = d->usr_field_redo;
+    cpy->usr_field_history = d->usr_field_history;
 
     cpy->field_edit_in_progress = 0;
 
@@ -163,6 +142,7 @@ pracdata *pracdata_cpy(pracdata *d)
     cpy->usr_timings->lineclear = d->usr_timings->lineclear;
     */
 
+    cpy->rewind = NULL;
     cpy->hist_index = 0;
     cpy->paused = QRS_FIELD_EDIT;
     cpy->grid_lines_shown = d->grid_lines_shown;
@@ -176,7 +156,7 @@ pracdata *pracdata_cpy(pracdata *d)
     return cpy;
 }
 
-std::vector<Shiro::PieceDefinition> qrspool_create()
+static std::vector<Shiro::PieceDefinition> qrspool_create(bool i4_no_wallkick)
 {
     std::vector<Shiro::PieceDefinition> pool(25);
     int n = 5;
@@ -202,6 +182,7 @@ std::vector<Shiro::PieceDefinition> qrspool_create()
                 pool[i].rotationTable[j] = Shiro::TetroRotationTables[i - 18][j];
             }
         }
+        pool[i].rotationMasks = &Shiro::PieceRotationMasks[i];
 
         if(!(i == QRS_I || i == QRS_N || i == QRS_G || i == QRS_J || i == QRS_L ||
              i == QRS_T || i == QRS_Ya || i == QRS_Yb || i == QRS_I4 || i == QRS_T4))
@@ -230,11 +211,24 @@ std::vector<Shiro::PieceDefinition> qrspool_create()
                 Shiro::PDAIRBORNEFKICKS
             );
         }
+
+        if(i == QRS_I4 && i4_no_wallkick)
+        {
+            pool[i].flags = static_cast<Shiro::PieceDefinitionFlag>(pool[i].flags | Shiro::PDNOWKICK);
+        }
     }
 
     return pool;
 }
 
+const Shiro::PieceDefinition *qrspool_get(bool i4_no_wallkick)
+{
+    static const std::vector<Shiro::PieceDefinition> standard = qrspool_create(false);
+    static const std::vector<Shiro::PieceDefinition> no_i4_wallkick = qrspool_create(true);
+
+    return i4_no_wallkick ? no_i4_wallkick.data() : standard.data();
+}
+
 Shiro::Grid *qrsfield_create()
 {
     return new Shiro::Grid(QRS_FIELD_W, QRS_FIELD_H);
@@ -278,7 +272,7 @@ int ufu_not_exists(CoreState *cs)
     if(!q)
         return 1;
 
-    if((q->pracdata->usr_field_undo.size() || q->pracdata->usr_field_redo.size()) && q->pracdata->paused == QRS_FIELD_EDIT)
+    if((q->pracdata->usr_field_history.undoSize() || q->pracdata->usr_field_history.redoSize()) && q->pracdata->paused == QRS_FIELD_EDIT)
         return 0;
     else
         return 1;
@@ -291,13 +285,11 @@ int usr_field_bkp(CoreState *cs, pracdata *d) {
         return 1;
     }
 
-    if (!d->usr_field_undo.size()) {
+    if (!d->usr_field_history.undoSize()) {
         gfx_createbutton(
             cs, "CLEAR UNDO", QRS_FIELD_X + (16 * 16) - 6, QRS_FIELD_Y + 23 * 16 + 8 - 6, 0, push_undo_clear_confirm, ufu_not_exists, NULL, 0xC0C0FFFF);
     }
-    d->usr_field_undo.push_back(d->usr_field);
-
-    d->usr_field_redo.clear();
+    d->usr_field_history.begin(d->usr_field);
 
     return 0;
 }
@@ -308,15 +300,11 @@ int usr_field_undo(CoreState *cs, pracdata *d)
         return 1;
     }
 
-    if (!d->usr_field_undo.size()) {
-        return 0;
+    // strokes only record cells they changed, so walls from a width change since have to be put back
+    if (d->usr_field_history.undo(d->usr_field)) {
+        qrsfield_set_w(&d->usr_field, d->field_w);
     }
 
-    d->usr_field_redo.push_back(d->usr_field);
-
-    d->usr_field = d->usr_field_undo.back();
-    d->usr_field_undo.pop_back();
-
     return 0;
 }
 
@@ -327,15 +315,10 @@ int usr_field_redo(CoreState *cs, pracdata *d)
         return 1;
     }
 
-    if (!d->usr_field_redo.size()) {
-        return 0;
+    if (d->usr_field_history.redo(d->usr_field)) {
+        qrsfield_set_w(&d->usr_field, d->field_w);
     }
 
-    d->usr_field_undo.push_back(d->usr_field);
-
-    d->usr_field = d->usr_field_redo.back();
-    d->usr_field_redo.pop_back();
-
     return 0;
 }
 
@@ -388,8 +371,7 @@ int usr_field_undo_clear(CoreState *cs, void *data)
 {
     qrsdata *q = (qrsdata *)cs->p1game->data;
 
-    q->pracdata->usr_field_undo.clear();
-    q->pracdata->usr_field_redo.clear();
+    q->pracdata->usr_field_history.clear();
 
     return 0;
 }
@@ -817,6 +799,9 @@ int qrs_input(game_t *g)
 
             if(!edit_action_occurred)
             {
+                if(d->field_edit_in_progress)
+                    d->usr_field_history.end(d->usr_field);
+
                 d->field_edit_in_progress = 0;
             }
         }
@@ -861,6 +846,17 @@ int qrs_input(game_t *g)
             return 1;
     }
 
+    // Ctrl+Z in the practice tool undoes the last placement; once the piece has locked, that's the piece just placed
+    if(d && d->paused != QRS_FIELD_EDIT && d->rewind && cs->undo)
+    {
+        cs->undo = false;
+
+        if(d->rewind->rewind(*g, (p->state & (PSFALL | PSLOCK)) ? 1u : 0u))
+            d->paused = 0;
+
+        return 0;
+    }
+
     if(init < 120)
         return 0;
 
@@ -951,15 +947,8 @@ int qrs_start_record(game_t *g)
 {
     qrsdata *q = (qrsdata *)g->data;
 
-    g2_seed_bkp();
-
-    q->replay = (struct replay *)malloc(sizeof(struct replay));
-    assert(q->replay != nullptr);
+    q->replay = new struct replay();
 
-    memset(q->replay->pinputs, 0, sizeof(struct packed_input) * MAX_KEYFLAGS);
-
-    q->replay->len = 0;
-    q->replay->mlen = 36000;
     q->replay->mode = q->mode_type;
     q->replay->mode_flags = q->mode_flags;
     q->replay->seed = q->randomizer_seed;
@@ -970,6 +959,16 @@ int qrs_start_record(game_t *g)
 
     q->replay->date = time(0);
 
+    // for comparing splits as each section ends; the last game's splits may still be queued, so they're folded in
+    // rather than waited for
+    std::vector<Shiro::SectionSplit> bestSplits = scoredb_get_best_splits(&g->origin->records, &g->origin->player, q->mode_type);
+    g->origin->recordWriter.foldQueuedBestSplits(g->origin->player, q->mode_type, bestSplits);
+    for(const Shiro::SectionSplit &split : bestSplits)
+    {
+        if(split.section >= 0 && split.section < MAX_SECTIONS)
+            q->best_section_times[split.section] = split.time;
+    }
+
     q->recording = 1;
     return 0;
 }
@@ -982,7 +981,15 @@ int qrs_end_record(game_t* g)
     q->replay->ending_level = q->level;
     q->replay->grade = q->grade;
 
-    scoredb_add(&g->origin->records, &g->origin->player, q->replay);
+    std::vector<Shiro::SectionSplit> splits;
+    for(int i = 0; i < MAX_SECTIONS; i++)
+    {
+        if(q->section_times[i] != -1)
+            splits.push_back({ 0, i, q->section_times[i], q->section_tetrises[i] });
+    }
+
+    // the replay's inputs go to the writer; it isn't recording anymore, so nothing reads them after this
+    g->origin->recordWriter.add(g->origin->player, std::move(*q->replay), std::move(splits));
 
     // TODO: Extract this into some (sum) method.
     int tetrisSum = 0;
@@ -993,9 +1000,8 @@ int qrs_end_record(game_t* g)
 
     g->origin->player.tetrisCount += tetrisSum;
 
-    scoredb_update_player(&g->origin->records, &g->origin->player);
+    g->origin->recordWriter.updatePlayer(g->origin->player);
 
-    g2_seed_restore();
     q->recording = 0;
     return 0;
 }
@@ -1004,7 +1010,7 @@ int qrs_load_replay(game_t *g, int replay_id)
 {
     qrsdata *q = (qrsdata *)g->data;
 
-    q->replay = (struct replay *)malloc(sizeof(struct replay));
+    q->replay = new struct replay();
     scoredb_get_full_replay(&g->origin->records, q->replay, replay_id);
 
     return 0;
@@ -1017,6 +1023,10 @@ int qrs_start_playback(game_t *g)
     q->playback = 1;
     q->playback_index = 0;
 
+    // only worth keeping when someone is watching; headless runs never seek
+    delete q->keyframes;
+    q->keyframes = g->sink ? new Shiro::ReplayKeyframes() : NULL;
+
     return 0;
 }
 
@@ -1144,7 +1154,8 @@ int qrs_irs(game_t *g)
         p->orient = 0;
     else if(direction)
     {
-        Shiro::SfxAsset::get(g->origin->assetMgr, "prerotate").play(g->origin->settings);
+        if(g->sink)
+            g->sink->playSfx("prerotate");
     }
 
     return 0;
@@ -1375,7 +1386,8 @@ int qrs_fall(game_t *g, qrs_player *p, int grav)
 
             if(p->state & PSFALL && grav != 28 * 256)
             {
-                Shiro::SfxAsset::get(g->origin->assetMgr, "land").play(g->origin->settings);
+                if(g->sink)
+                    g->sink->playSfx("land");
             }
             p->state &= ~PSFALL;
             p->state |= PSLOCK;
@@ -1420,7 +1432,8 @@ int qrs_lock(game_t *g, qrs_player *p)
 
     p->state &= ~(PSLOCK | PSFALL);
     // p->state |= PSPRELOCKFLASH1;
-    Shiro::SfxAsset::get(g->origin->assetMgr, "lock").play(g->origin->settings);
+    if(g->sink)
+        g->sink->playSfx("lock");
 
     return 0;
 }
@@ -1431,25 +1444,33 @@ bool qrs_chkcollision(game_t& g, qrs_player& p) {
 }
 
 bool qrs_chkcollision(game_t& g, qrs_player& p, std::pair<int, int>& pos) {
-    Shiro::Grid *d = &p.def->rotationTable[p.orient];
-    Shiro::Grid *f = g.field;
-    int d_x = 0;
-    int d_y = 0;
-    //int d_val = 0;
-    int f_x = 0;
-    int f_y = 0;
-    //int f_val = 0;
-
-    for (d_y = 0, f_y = YTOROW(p.y) - p.def->anchorY; d_y < int(d->getHeight()); d_y++, f_y++) {
-        for (d_x = 0, f_x = p.x - p.def->anchorY; d_x < int(d->getWidth()); d_x++, f_x++) {
-            if (d->getCell(d_x, d_y) && f->getCell(f_x, f_y)) {
-                pos = std::pair(d_x, d_y);
+    const int x = p.x - p.def->anchorY;
+    const int y = YTOROW(p.y) - p.def->anchorY;
+    const int shift = x + Shiro::Grid::occupancyPadding;
+
+    // Row-at-a-time test against the field's occupancy bitboard; walls and
+    // out-of-bounds cells are preset in the bitboard.
+    if(p.def->rotationMasks && shift >= 0 && shift <= 64 - int(Shiro::RotationMask::maxSize))
+    {
+        const Shiro::RotationMask& mask = (*p.def->rotationMasks)[p.orient];
+        for(int row = 0; row < mask.height; row++)
+        {
+            const uint64_t overlap = mask.rows[row] & (g.field->occupancy(y + row) >> shift);
+            if(overlap)
+            {
+                int column = 0;
+                while(!(overlap & (UINT64_C(1) << column)))
+                    column++;
+
+                pos = std::pair<int, int>(column, row);
                 return true;
             }
         }
+
+        return false;
     }
 
-    return false;
+    return g.field->collides(p.def->rotationTable[p.orient], x, y, pos);
 }
 
 int qrs_isonground(game_t *g, qrs_player *p)
@@ -1500,6 +1521,15 @@ int qrs_lineclear(game_t *g, qrs_player *p)
             j++;
         }
 
+        // A row can only be full if every cell of the playable width is
+        // occupied, so skip the cell scan for rows with a gap in the bitboard.
+        const uint64_t rowBits = g->field->occupancy(i) >> (Shiro::Grid::occupancyPadding + startX);
+        const uint64_t playableBits = (UINT64_C(1) << q->field_w) - 1u;
+        if((rowBits & playableBits) != playableBits)
+        {
+            continue;
+        }
+
         for(; j < startX + q->field_w; j++)
         {
             int cell = g->field->getCell(j, i);
@@ -1525,7 +1555,8 @@ int qrs_lineclear(game_t *g, qrs_player *p)
             n++;
             if(!(q->state_flags & GAMESTATE_BIGMODE))
             {
-                gfx_qs_lineclear(g, i);
+                if(g->sink)
+                    g->sink->lineClear(g, i);
             }
 
             for(j = startX; j < startX + q->field_w; j++)
@@ -1560,9 +1591,16 @@ int qrs_dropfield(game_t *g)
         while(field->getCell(4, static_cast<std::size_t>(i) - n) == -2)
             n++;
 
-        if(i - n >= 0)
+        if(i - n > 0)
         {
-            field->copyRow(static_cast<std::size_t>(i) - n, i);
+            // swapping rather than copying leaves the row at i - n holding
+            // stale contents, but it's always overwritten or reset later
+            field->swapRows(static_cast<std::size_t>(i) - n, i);
+        }
+        else if(i - n == 0)
+        {
+            // row 0 isn't revisited by this loop, so it has to keep its contents
+            field->copyRow(0u, i);
         }
         else
         {
@@ -1601,7 +1639,7 @@ int qrs_spawn_garbage(game_t *g, unsigned int flags)
     {
         for(i = 0u; i < QRS_FIELD_H - 1; i++)
         {
-            g->field->copyRow(i + 1, i);
+            g->field->swapRows(i + 1, i);
         }
 
         g->field->copyRow(QRS_FIELD_H - 2, QRS_FIELD_H - 1);
@@ -1628,6 +1666,9 @@ int qrs_spawn_garbage(game_t *g, unsigned int flags)
 
 void qrs_embiggen(Shiro::PieceDefinition& p)
 {
+    // the rotation tables won't match the built-in masks anymore
+    p.rotationMasks = nullptr;
+
     int xs[5] = {-1, -1, -1, -1, -1};
     int ys[5] = {-1, -1, -1, -1, -1};
     std::size_t k = 0;
@@ -1,9 +1,11 @@
 #pragma once
+#include "FieldEditHistory.h"
 #include "Game.h"
 #include "GameType.h"
 #include "Grid.h"
 #include "PieceDefinition.h"
 #include "Timer.h"
+#include "UserSequence.h"
 #include <array>
 #include <cstdint>
 #include <fstream>
@@ -13,6 +15,11 @@
 
 #define MAX_SECTIONS 30
 
+namespace Shiro {
+    class PracticeRewind;
+    class ReplayKeyframes;
+}
+
 #define PSINACTIVE         0x0000
 
 #define PSARE             0x0001
@@ -212,17 +219,11 @@ struct pracdata
     Shiro::GameType game_type;    // mirrors of values in qrsdata; these are just here so that..
     int field_w;    // ..backed up pracdata structs can be used to restore their values
 
-    //int *long_history;        // old idea, just history of all pieces placed,
-                                // going to re-add long_history but with placement locations included,
-                                // as well as game time/level, to allow piece-by-piece rewinds
+    Shiro::PracticeRewind *rewind; // piece-by-piece history of the game being played, for stepping back
 
-    int usr_sequence[2000];
-    int usr_seq_expand[4000];
-    std::size_t usr_seq_len;
-    std::size_t usr_seq_expand_len;
+    Shiro::UserSequence usr_sequence;
 
-    std::vector<Shiro::Grid> usr_field_undo;
-    std::vector<Shiro::Grid> usr_field_redo;
+    Shiro::FieldEditHistory usr_field_history;
     bool field_edit_in_progress;
 
     Shiro::Grid usr_field;
@@ -250,10 +251,11 @@ struct pracdata
 
 struct qrsdata
 {
-    std::vector<Shiro::PieceDefinition> piecepool;
+    const Shiro::PieceDefinition *piecepool; // a shared pool from qrspool_get, indexed by piece_id
     struct randomizer *randomizer;
     struct pracdata *pracdata;
     struct replay *replay;
+    Shiro::ReplayKeyframes *keyframes; // seek points while a replay is played back with a sink, otherwise NULL
     std::ifstream credits;
     Shiro::Grid garbage;
     piece_id *piece_seq;
@@ -339,6 +341,8 @@ struct qrsdata
     long cur_section_timestamp;
     int section_times[MAX_SECTIONS];
     int section_tetrises[MAX_SECTIONS];
+    // the player's fastest time for each section of this mode, loaded when recording starts; -1 if there isn't one
+    int best_section_times[MAX_SECTIONS];
 
     // values: 1 = set to 2 next time a rotate happens.
     //           2 = lock during THIS frame ( handled by qs_process_lock() )
@@ -378,7 +382,10 @@ const std::string get_qrspiece_name(std::size_t n);
 void qrsdata_destroy(qrsdata *q);
 void pracdata_destroy(struct pracdata *d);
 
-std::vector<Shiro::PieceDefinition> qrspool_create();
+// The piece pools are built the first time they're asked for and shared by
+// every game after that, so they must never be modified. With
+// i4_no_wallkick, the I tetromino can't wall kick (the G1/G2 rules).
+const Shiro::PieceDefinition *qrspool_get(bool i4_no_wallkick);
 
 Shiro::Grid* qrsfield_create();
 int qrsfield_set_w(Shiro::Grid* field, int w);
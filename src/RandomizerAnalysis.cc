@@ -0,0 +1,265 @@
+#include "RandomizerAnalysis.h"
+#include "random.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// droughts this long or longer all land in the last histogram bucket
+#define ANALYSIS_MAX_DROUGHT 256
+#define ANALYSIS_SHARD_PIECES (1ull << 20)
+#define ANALYSIS_MAX_PIECES 25
+
+namespace {
+    struct AnalysisType {
+        const char *name;
+        struct randomizer *(*create)(uint32_t flags);
+        unsigned int num_pieces;
+        // a piece dealt again within this many pieces counts as a flood
+        unsigned int flood_window;
+        bool has_difficulty;
+        const char *const *piece_names;
+    };
+
+    const char *const pento_names[ANALYSIS_MAX_PIECES] = {
+        "I", "J", "L", "X", "S", "Z", "N", "G", "U", "T", "Fa", "Fb", "P",
+        "Q", "W", "Ya", "Yb", "V", "I4", "T4", "J4", "L4", "O", "S4", "Z4"
+    };
+    // g1/g2/g3 deal Arika piece IDs (ARS_I and so on), not QRS ones
+    const char *const ars_names[7] = { "I", "Z", "S", "J", "L", "O", "T" };
+
+    const AnalysisType analysis_types[] = {
+        { "pento", pento_randomizer_create, 25, 6, true, pento_names },
+        { "g1", g1_randomizer_create, 7, 4, false, ars_names },
+        { "g2", g2_randomizer_create, 7, 4, false, ars_names },
+        { "g3", g3_randomizer_create, 7, 4, false, ars_names },
+    };
+
+    // the difficulties the game sets over the course of a pentomino game
+    const double analysis_difficulties[] = { 0.0, 10.0, 15.0, 29.0, 40.0, 50.0 };
+
+    // everything in here merges by addition (or max), so the merge order doesn't matter
+    struct AnalysisStats {
+        std::array<uint64_t, ANALYSIS_MAX_PIECES> dealt{};
+        std::array<uint64_t, ANALYSIS_MAX_PIECES> drought_sum{};
+        std::array<uint64_t, ANALYSIS_MAX_PIECES> drought_max{};
+        std::array<std::array<uint64_t, ANALYSIS_MAX_DROUGHT + 1>, ANALYSIS_MAX_PIECES> droughts{};
+
+        void merge(const AnalysisStats &other)
+        {
+            for(std::size_t i = 0; i < ANALYSIS_MAX_PIECES; i++)
+            {
+                dealt[i] += other.dealt[i];
+                drought_sum[i] += other.drought_sum[i];
+                drought_max[i] = std::max(drought_max[i], other.drought_max[i]);
+                for(std::size_t j = 0; j <= ANALYSIS_MAX_DROUGHT; j++)
+                    droughts[i][j] += other.droughts[i][j];
+            }
+        }
+    };
+}
+
+static uint32_t shard_seed(uint32_t base_seed, uint64_t shard)
+{
+    uint32_t s = base_seed ^ uint32_t(shard * 0x9e3779b97f4a7c15ull >> 32);
+    return g2_rand_rep(s ^ uint32_t(shard), 4);
+}
+
+static void analyze_shard(const AnalysisType &type, double difficulty, uint32_t seed, uint64_t pieces, AnalysisStats &stats)
+{
+    std::array<uint64_t, ANALYSIS_MAX_PIECES> last_seen;
+    std::array<bool, ANALYSIS_MAX_PIECES> seen{};
+    struct randomizer *r = type.create(0);
+
+    if(type.has_difficulty)
+        histrand_set_difficulty(r, difficulty);
+    r->init(r, &seed);
+
+    for(uint64_t i = 0; i < pieces; i++)
+    {
+        piece_id t = r->pull(r);
+
+        if(t >= type.num_pieces)
+            continue;
+
+        stats.dealt[t]++;
+
+        // droughts are only counted between two appearances inside this shard
+        if(seen[t])
+        {
+            uint64_t drought = i - last_seen[t];
+            stats.drought_sum[t] += drought;
+            stats.drought_max[t] = std::max(stats.drought_max[t], drought);
+            stats.droughts[t][std::min<uint64_t>(drought, ANALYSIS_MAX_DROUGHT)]++;
+        }
+
+        seen[t] = true;
+        last_seen[t] = i;
+    }
+
+    randomizer_destroy(r);
+}
+
+static AnalysisStats analyze(const AnalysisType &type, double difficulty, uint32_t base_seed, uint64_t pieces, unsigned int num_threads)
+{
+    const uint64_t num_shards = (pieces + ANALYSIS_SHARD_PIECES - 1) / ANALYSIS_SHARD_PIECES;
+    std::atomic<uint64_t> next_shard{ 0 };
+    std::vector<AnalysisStats> results(num_threads);
+    std::vector<std::thread> workers;
+
+    for(unsigned int w = 0; w < num_threads; w++)
+    {
+        workers.emplace_back([&, w]() {
+            for(uint64_t shard = next_shard++; shard < num_shards; shard = next_shard++)
+            {
+                uint64_t shard_pieces = std::min<uint64_t>(ANALYSIS_SHARD_PIECES, pieces - shard * ANALYSIS_SHARD_PIECES);
+                analyze_shard(type, difficulty, shard_seed(base_seed, shard), shard_pieces, results[w]);
+            }
+        });
+    }
+
+    AnalysisStats total;
+    for(unsigned int w = 0; w < num_threads; w++)
+    {
+        workers[w].join();
+        total.merge(results[w]);
+    }
+
+    return total;
+}
+
+// smallest drought length at or below which the given fraction of droughts fall
+static uint64_t drought_percentile(const std::array<uint64_t, ANALYSIS_MAX_DROUGHT + 1> &histogram, uint64_t total, double fraction)
+{
+    uint64_t running = 0;
+
+    for(std::size_t j = 0; j <= ANALYSIS_MAX_DROUGHT; j++)
+    {
+        running += histogram[j];
+        if(total > 0 && double(running) >= fraction * double(total))
+            return j;
+    }
+
+    return ANALYSIS_MAX_DROUGHT;
+}
+
+static void print_report(const AnalysisType &type, const AnalysisStats &stats)
+{
+    uint64_t all_dealt = 0;
+    std::array<uint64_t, ANALYSIS_MAX_DROUGHT + 1> all_droughts{};
+
+    for(unsigned int i = 0; i < type.num_pieces; i++)
+    {
+        all_dealt += stats.dealt[i];
+        for(std::size_t j = 0; j <= ANALYSIS_MAX_DROUGHT; j++)
+            all_droughts[j] += stats.droughts[i][j];
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "  piece    freq%   mean   p50   p99 p99.9    max  repeat%   flood%" << std::endl;
+
+    for(unsigned int i = 0; i < type.num_pieces; i++)
+    {
+        uint64_t droughts = 0;
+        for(std::size_t j = 0; j <= ANALYSIS_MAX_DROUGHT; j++)
+            droughts += stats.droughts[i][j];
+
+        uint64_t floods = 0;
+        for(std::size_t j = 1; j <= type.flood_window; j++)
+            floods += stats.droughts[i][j];
+
+        auto percent = [](uint64_t part, uint64_t whole) { return whole ? 100.0 * double(part) / double(whole) : 0.0; };
+
+        std::cout << "  " << std::setw(5) << type.piece_names[i]
+                  << std::setw(9) << percent(stats.dealt[i], all_dealt)
+                  << std::setw(7) << std::setprecision(1) << (droughts ? double(stats.drought_sum[i]) / double(droughts) : 0.0)
+                  << std::setw(6) << drought_percentile(stats.droughts[i], droughts, 0.5)
+                  << std::setw(6) << drought_percentile(stats.droughts[i], droughts, 0.99)
+                  << std::setw(6) << drought_percentile(stats.droughts[i], droughts, 0.999)
+                  << std::setw(7) << stats.drought_max[i]
+                  << std::setprecision(3)
+                  << std::setw(9) << percent(stats.droughts[i][1], droughts)
+                  << std::setw(9) << percent(floods, droughts) << std::endl;
+    }
+
+    // all pieces together, in power-of-two buckets
+    std::cout << "  droughts:";
+    for(std::size_t low = 1; low <= ANALYSIS_MAX_DROUGHT; low *= 2)
+    {
+        std::size_t high = std::min<std::size_t>(low * 2 - 1, ANALYSIS_MAX_DROUGHT - 1);
+        uint64_t count = 0;
+
+        if(low == ANALYSIS_MAX_DROUGHT)
+        {
+            count = all_droughts[ANALYSIS_MAX_DROUGHT];
+            std::cout << " " << low << "+:" << count;
+            break;
+        }
+
+        for(std::size_t j = low; j <= high; j++)
+            count += all_droughts[j];
+
+        std::cout << " " << low;
+        if(high != low)
+            std::cout << "-" << high;
+        std::cout << ":" << count;
+    }
+    std::cout << std::endl;
+}
+
+int randomizer_analysis(int argc, const char *const args[])
+{
+    if(argc < 1)
+    {
+        std::cerr << "Usage: --analyze-randomizer <pento|g1|g2|g3> [pieces] [seed] [threads]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const AnalysisType *type = nullptr;
+    for(const AnalysisType &candidate : analysis_types)
+    {
+        if(std::strcmp(args[0], candidate.name) == 0)
+            type = &candidate;
+    }
+
+    if(!type)
+    {
+        std::cerr << "Unknown randomizer `" << args[0] << "`" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    uint64_t pieces = argc >= 2 ? std::strtoull(args[1], nullptr, 10) : 100000000ull;
+    uint32_t seed = argc >= 3 ? uint32_t(std::strtoul(args[2], nullptr, 10)) : 0u;
+    unsigned int num_threads = argc >= 4 ? unsigned(std::strtoul(args[3], nullptr, 10)) : std::thread::hardware_concurrency();
+
+    if(num_threads == 0)
+        num_threads = 1;
+
+    // the thread count goes to stderr so reports can be diffed across machines
+    std::cerr << "Using " << num_threads << " threads" << std::endl;
+    std::cout << type->name << ": " << pieces << " pieces, seed " << seed << ", flood window " << type->flood_window
+              << ", droughts of " << ANALYSIS_MAX_DROUGHT << " or more are bucketed together" << std::endl;
+
+    if(type->has_difficulty)
+    {
+        for(double difficulty : analysis_difficulties)
+        {
+            std::cout << std::endl << "difficulty " << std::setprecision(1) << std::fixed << difficulty << std::endl;
+            print_report(*type, analyze(*type, difficulty, seed, pieces, num_threads));
+        }
+    }
+    else
+    {
+        std::cout << std::endl;
+        print_report(*type, analyze(*type, 0.0, seed, pieces, num_threads));
+    }
+
+    return EXIT_SUCCESS;
+}
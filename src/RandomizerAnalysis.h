@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * `--analyze-randomizer <pento|g1|g2|g3> [pieces] [seed] [threads]`: deals
+ * `pieces` pieces (per difficulty, for pento) from the given randomizer on
+ * every core and prints piece frequencies, drought histograms and flood
+ * rates. The work is cut into fixed-size shards, each with its own seed
+ * derived from `seed` and the shard number, so the report is the same for
+ * any thread count. `args` are the arguments following the flag. Returns an
+ * exit code.
+ */
+int randomizer_analysis(int argc, const char *const args[]);
@@ -0,0 +1,269 @@
+#include "RandomizerBenchmark.h"
+#include "random.h"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+/* histrand_get_next as it was before it kept its scratch state in struct
+   histrand_data; kept verbatim as the reference the new one must match */
+static piece_id reference_histrand_get_next(struct randomizer *r)
+{
+    struct histrand_data *d = (struct histrand_data *)r->data;
+    uint32_t *seedp = &r->seed;
+    unsigned int i = 0;
+    unsigned int j = 0;
+    bool in_hist = false;
+    piece_id t = PIECE_ID_INVALID;
+
+    long double p = 0.0;
+    double old_sum = 0.0;
+    double sum = 0.0;
+    unsigned int *histogram = (unsigned int *)malloc(r->num_pieces * sizeof(unsigned int));
+    double *temp_weights = (double *)malloc(r->num_pieces * sizeof(double));
+
+    if(!d->piece_weights)
+    {
+        for(i = 0; i < d->rerolls; i++)
+        {
+            t = g123_read_rand(seedp) % 7;
+
+            in_hist = 0;
+            for(j = 0; j < d->hist_len; j++)
+            {
+                if(d->history[j] == t)
+                    in_hist = true;
+            }
+
+            if(!in_hist)
+                break;
+
+            t = g123_read_rand(seedp) % 7;
+        }
+
+        free(temp_weights);
+        free(histogram);
+
+        return t;
+    }
+
+    int below_high_threshold = 1;
+
+    for(i = 0; i < r->num_pieces; i++)
+    {
+        temp_weights[i] = d->piece_weights[i];
+        histogram[i] = 1;
+
+        for(j = 0; j < d->hist_len; j++)
+        {
+            if(d->history[j] == i)
+            {
+                histogram[i]++;
+                if(d->piece_weights[i] < QRS_WEIGHT_HIGHTIER_THRESHOLD)
+                {
+                    below_high_threshold++;
+                }
+            }
+        }
+
+        temp_weights[i] /= (double)histogram[i] * histogram[i];
+        if(d->drought_protection_coefficients && d->drought_times)
+        {
+            temp_weights[i] *= pow(d->drought_protection_coefficients[i], (double)(d->drought_times[i]) / QRS_DROUGHT_BASELINE);
+
+            if((d->piece_weights[i] >= QRS_WEIGHT_HIGHTIER_THRESHOLD) && (QRS_DROUGHT_HIGHTIER_SOFTLIMIT >= 0))
+            {
+                if(d->drought_times[i] >= QRS_DROUGHT_HIGHTIER_SOFTLIMIT)
+                {
+                    temp_weights[i] *= pow(1.3, (double)d->drought_times[i] - QRS_DROUGHT_HIGHTIER_SOFTLIMIT + 1.0);
+                }
+            }
+            else if((d->difficulty >= 30.0) && (d->piece_weights[i] >= QRS_WEIGHT_MIDTIER_THRESHOLD) && (QRS_DROUGHT_MIDTIER_SOFTLIMIT >= 0))
+            {
+                if(d->drought_times[i] >= QRS_DROUGHT_MIDTIER_SOFTLIMIT)
+                {
+                    temp_weights[i] *= pow(1.3, (double)d->drought_times[i] - QRS_DROUGHT_MIDTIER_SOFTLIMIT + 1.0);
+                }
+            }
+            else if((d->difficulty >= 30.0) && (QRS_DROUGHT_LOWTIER_SOFTLIMIT >= 0))
+            {
+                if(int(d->drought_times[i]) >= QRS_DROUGHT_LOWTIER_SOFTLIMIT)
+                {
+                    temp_weights[i] *= pow(1.3, (double)d->drought_times[i] - QRS_DROUGHT_LOWTIER_SOFTLIMIT + 1.0);
+                }
+            }
+        }
+    }
+
+    for(i = 0; i < r->num_pieces; i++)
+    {
+        if(d->piece_weights[i] < QRS_WEIGHT_HIGHTIER_THRESHOLD)
+        {
+            temp_weights[i] /= (double)(below_high_threshold);
+        }
+
+        if((d->difficulty < 30.0) && (d->piece_weights[i] >= QRS_WEIGHT_TOPTIER_THRESHOLD))
+        {
+            temp_weights[i] *= pow(1.1, (30.0 - d->difficulty) / 3);
+        }
+
+        if((d->difficulty < 30.0) && (d->piece_weights[i] >= QRS_WEIGHT_HIGHTIER_THRESHOLD) && (d->piece_weights[i] < QRS_WEIGHT_TOPTIER_THRESHOLD))
+        {
+            temp_weights[i] *= pow(1.1, (30.0 - d->difficulty) / 6);
+        }
+
+        sum += temp_weights[i];
+    }
+
+    if(d->difficulty > 30.0)
+    {
+        old_sum = sum;
+        sum = 0.0;
+
+        for(i = 0; i < r->num_pieces; i++)
+        {
+            temp_weights[i] += ((d->difficulty - 30.0) / 100.0) * ((old_sum / r->num_pieces) - temp_weights[i]);
+
+            sum += temp_weights[i];
+        }
+    }
+
+    p = (long double)(pento_read_rand(seedp)) / (long double)(PENTO_READ_RAND_MAX);
+    p = p * (long double)(sum);
+    sum = 0.0;
+
+    for(i = 0; i < r->num_pieces; i++)
+    {
+        if(p >= (long double)(sum) && p < (long double)(sum + temp_weights[i]))
+        {
+            free(temp_weights);
+            free(histogram);
+            return i;
+        }
+        else
+            sum += temp_weights[i];
+    }
+
+    free(temp_weights);
+    free(histogram);
+
+    return 0;
+}
+
+// histrand_pull, but going through the reference implementation
+static piece_id reference_histrand_pull(struct randomizer *r)
+{
+    struct histrand_data *d = (struct histrand_data *)r->data;
+    piece_id t = reference_histrand_get_next(r);
+    piece_id result = history_pop(d->history);
+
+    history_push(d->history, d->hist_len, t);
+
+    if(d->drought_times)
+    {
+        for(unsigned int i = 0; i < r->num_pieces; i++)
+        {
+            if(i == t)
+                d->drought_times[i] = 0;
+            else
+                d->drought_times[i]++;
+        }
+    }
+
+    return result;
+}
+
+/* the difficulties the game actually sets, so every branch of the weighting
+   (below 30, the softlimit tiers at and above 30, and above 30) is exercised */
+static const double benchmark_difficulties[] = { 0.0, 10.0, 15.0, 29.0, 30.0, 40.0, 50.0 };
+
+int randomizer_benchmark(int argc, const char *const args[])
+{
+    unsigned long seeds = 1000;
+    unsigned long pieces = 10000;
+
+    if(argc >= 1)
+        seeds = std::strtoul(args[0], nullptr, 10);
+    if(argc >= 2)
+        pieces = std::strtoul(args[1], nullptr, 10);
+
+    struct randomizer *(*const creators[])(uint32_t) = { g1_randomizer_create, g2_randomizer_create, pento_randomizer_create };
+    const char *const names[] = { "g1", "g2", "pento" };
+    const std::size_t num_difficulties = sizeof(benchmark_difficulties) / sizeof(benchmark_difficulties[0]);
+    unsigned long mismatches = 0;
+
+    for(std::size_t c = 0; c < sizeof(creators) / sizeof(creators[0]); c++)
+    {
+        std::chrono::steady_clock::duration reference_time{};
+        std::chrono::steady_clock::duration current_time{};
+        unsigned long current_hash = 0;
+        unsigned long reference_hash = 0;
+
+        for(unsigned long s = 0; s < seeds; s++)
+        {
+            uint32_t seed = g2_rand_rep(uint32_t(s), 3);
+            double difficulty = benchmark_difficulties[s % num_difficulties];
+
+            struct randomizer *current = creators[c](0);
+            struct randomizer *reference = creators[c](0);
+
+            histrand_set_difficulty(current, difficulty);
+            current->init(current, &seed);
+            histrand_set_difficulty(reference, difficulty);
+            reference->init(reference, &seed);
+
+            // lockstep: both implementations have to pick the same piece and consume the same random numbers
+            struct histrand_data *d = (struct histrand_data *)current->data;
+            for(unsigned long i = 0; i < pieces && mismatches == 0; i++)
+            {
+                uint32_t seed_before = current->seed;
+                piece_id expected = reference_histrand_get_next(current);
+                uint32_t expected_seed = current->seed;
+
+                current->seed = seed_before;
+                histrand_pull(current);
+
+                if(d->history[d->hist_len - 1] != expected || current->seed != expected_seed)
+                {
+                    std::cerr << names[c] << ": seed " << seed << ", difficulty " << difficulty << ", piece " << i
+                              << ": expected " << int(expected) << ", got " << int(d->history[d->hist_len - 1]) << std::endl;
+                    mismatches++;
+                }
+            }
+
+            // timing: the same stream again from the start, once per implementation
+            current->init(current, &seed);
+            auto start = std::chrono::steady_clock::now();
+            for(unsigned long i = 0; i < pieces; i++)
+                current_hash = current_hash * 31 + current->pull(current);
+            current_time += std::chrono::steady_clock::now() - start;
+
+            start = std::chrono::steady_clock::now();
+            for(unsigned long i = 0; i < pieces; i++)
+                reference_hash = reference_hash * 31 + reference_histrand_pull(reference);
+            reference_time += std::chrono::steady_clock::now() - start;
+
+            randomizer_destroy(current);
+            randomizer_destroy(reference);
+        }
+
+        auto nanoseconds = [](std::chrono::steady_clock::duration duration) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        };
+        double total = double(seeds) * double(pieces);
+
+        std::cout << names[c] << ": " << seeds << " seeds x " << pieces << " pieces, "
+                  << (total > 0 ? nanoseconds(reference_time) / total : 0.0) << " ns/piece before, "
+                  << (total > 0 ? nanoseconds(current_time) / total : 0.0) << " ns/piece now"
+                  << (current_hash == reference_hash ? "" : " (sequences differ!)") << std::endl;
+
+        if(current_hash != reference_hash)
+            mismatches++;
+    }
+
+    std::cout << (mismatches == 0 ? "identical output" : "OUTPUT DIFFERS") << std::endl;
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+ * `--benchmark-randomizer [seeds] [pieces]`: checks that histrand_get_next
+ * produces exactly the pieces (and leaves exactly the RNG state) of the
+ * original allocating, pow()-per-piece implementation kept in
+ * RandomizerBenchmark.cc, for `seeds` seeds and `pieces` pulls each, then
+ * times both. `args` are the arguments following the flag. Returns an exit
+ * code; nonzero if any pull differed.
+ */
+int randomizer_benchmark(int argc, const char *const args[]);
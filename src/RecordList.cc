@@ -6,53 +6,457 @@
 #include <cstdint>
 #include <cstdlib>
 #include <iostream>
-#include <cassert>
+#include <string>
 #include <sqlite3.h>
 #define check_bind(db, bind_call) check((bind_call) == SQLITE_OK, "Could not bind parameter value: %s", sqlite3_errmsg((db)))
 
 static const int MAX_PLAYER_NAME_LENGTH = 64;
 
+// migrations[n] takes the schema from version n to n + 1, and runs in a transaction with the version update. Only
+// ever add to the end: every database is at one of these versions.
+static const char *const migrations[] = {
+    // 1: players and scores. Databases from before schema versions already have these tables, so they're only
+    // created if they don't exist.
+    "CREATE TABLE IF NOT EXISTS players ("
+    "    playerId INTEGER PRIMARY KEY, "
+    "    name VARCHAR(64) UNIQUE NOT NULL COLLATE NOCASE, "
+    "    tetroCount INTEGER DEFAULT(0), "
+    "    pentoCount INTEGER DEFAULT(0), "
+    "    tetrisCount INTEGER DEFAULT(0)"
+    "); "
+    "CREATE TABLE IF NOT EXISTS scores ("
+    "    scoreId INTEGER PRIMARY KEY, "
+    "    playerId INTEGER NOT NULL, "
+    "    mode INTEGER, "
+    "    grade INTEGER, "
+    "    startlevel INTEGER, "
+    "    level INTEGER, "
+    "    time INTEGER, "
+    "    replay BLOB, "
+    "    date INTEGER, "
+    "    FOREIGN KEY(playerId) REFERENCES players(playerId) "
+    ");",
+
+    // 2: indexes in the order of the replay list and the leaderboard. The replay list's covers every column it
+    // shows, so listing a player's replays never reads the scores table, and scoreId is in its key so it's in
+    // the list's order exactly. The leaderboard's finds a mode's best score without a sort, so only the one
+    // replay it returns is read.
+    "CREATE INDEX IF NOT EXISTS scoresByPlayer "
+    "    ON scores (playerId, mode, level DESC, time, scoreId, grade, startLevel, date); "
+    "CREATE INDEX IF NOT EXISTS scoresByMode "
+    "    ON scores (mode, grade DESC, level DESC, time, date);",
+
+    // 3: replays move out of scores into their own table, so scores only has the narrow rows that lists and
+    // leaderboards read, and a replay is only read when it's played. SQLite can't drop a column before 3.35, so
+    // scores is rebuilt without it; the old table is renamed out of the way first, so the replays table can
+    // reference the new one.
+    "DROP INDEX scoresByPlayer; "
+    "DROP INDEX scoresByMode; "
+    "ALTER TABLE scores RENAME TO oldScores; "
+    "CREATE TABLE scores ("
+    "    scoreId INTEGER PRIMARY KEY, "
+    "    playerId INTEGER NOT NULL, "
+    "    mode INTEGER, "
+    "    grade INTEGER, "
+    "    startlevel INTEGER, "
+    "    level INTEGER, "
+    "    time INTEGER, "
+    "    date INTEGER, "
+    "    FOREIGN KEY(playerId) REFERENCES players(playerId) "
+    "); "
+    "INSERT INTO scores (scoreId, playerId, mode, grade, startlevel, level, time, date) "
+    "    SELECT scoreId, playerId, mode, grade, startlevel, level, time, date FROM oldScores; "
+    "CREATE TABLE replays ("
+    "    scoreId INTEGER PRIMARY KEY, "
+    "    replay BLOB NOT NULL, "
+    "    FOREIGN KEY(scoreId) REFERENCES scores(scoreId) "
+    "); "
+    "INSERT INTO replays (scoreId, replay) "
+    "    SELECT scoreId, replay FROM oldScores WHERE replay IS NOT NULL; "
+    "DROP TABLE oldScores; "
+    "CREATE INDEX scoresByPlayer "
+    "    ON scores (playerId, mode, level DESC, time, scoreId, grade, startLevel, date); "
+    "CREATE INDEX scoresByMode "
+    "    ON scores (mode, grade DESC, level DESC, time, date);",
+
+    // 4: every player's best score in each mode, kept up to date by a trigger as scores are added, so personal
+    // bests and leaderboards only read one row per player instead of everything they've ever played. A score
+    // replaces a best if it's better in leaderboard order (grade, then level, then time); ties keep the older one.
+    // Scores are never deleted, so there's no trigger for that. Existing scores are run through the same upsert
+    // in the order they were added. The leaderboard is the mode's personal bests in order, which also makes
+    // scoresByMode redundant.
+    "CREATE TABLE personalBests ("
+    "    playerId INTEGER NOT NULL, "
+    "    mode INTEGER NOT NULL, "
+    "    scoreId INTEGER NOT NULL, "
+    "    grade INTEGER, "
+    "    startLevel INTEGER, "
+    "    level INTEGER, "
+    "    time INTEGER, "
+    "    date INTEGER, "
+    "    PRIMARY KEY (playerId, mode), "
+    "    FOREIGN KEY(playerId) REFERENCES players(playerId), "
+    "    FOREIGN KEY(scoreId) REFERENCES scores(scoreId) "
+    ") WITHOUT ROWID; "
+    "CREATE INDEX personalBestsByMode "
+    "    ON personalBests (mode, grade DESC, level DESC, time, date); "
+    "INSERT INTO personalBests (playerId, mode, scoreId, grade, startLevel, level, time, date) "
+    "    SELECT playerId, mode, scoreId, grade, startLevel, level, time, date FROM scores "
+    "    WHERE true "
+    "    ORDER BY scoreId "
+    "ON CONFLICT (playerId, mode) DO UPDATE SET "
+    "    scoreId = excluded.scoreId, grade = excluded.grade, startLevel = excluded.startLevel, "
+    "    level = excluded.level, time = excluded.time, date = excluded.date "
+    "WHERE excluded.grade > grade OR (excluded.grade = grade AND ("
+    "    excluded.level > level OR (excluded.level = level AND excluded.time < time))); "
+    "CREATE TRIGGER updatePersonalBest AFTER INSERT ON scores "
+    "BEGIN "
+    "    INSERT INTO personalBests (playerId, mode, scoreId, grade, startLevel, level, time, date) "
+    "        VALUES (NEW.playerId, NEW.mode, NEW.scoreId, NEW.grade, NEW.startLevel, NEW.level, NEW.time, NEW.date) "
+    "    ON CONFLICT (playerId, mode) DO UPDATE SET "
+    "        scoreId = excluded.scoreId, grade = excluded.grade, startLevel = excluded.startLevel, "
+    "        level = excluded.level, time = excluded.time, date = excluded.date "
+    "    WHERE excluded.grade > grade OR (excluded.grade = grade AND ("
+    "        excluded.level > level OR (excluded.level = level AND excluded.time < time))); "
+    "END; "
+    "DROP INDEX scoresByMode;",
+
+    // 5: section splits. Each split is a narrow row clustered by player, mode and section, so a section's history
+    // is one contiguous range; bestSplits keeps each section's fastest split up to date the same way
+    // personalBests does, so a best possible run reads one row per section. Games from before this version have
+    // no splits.
+    "CREATE TABLE splits ("
+    "    playerId INTEGER NOT NULL, "
+    "    mode INTEGER NOT NULL, "
+    "    section INTEGER NOT NULL, "
+    "    scoreId INTEGER NOT NULL, "
+    "    time INTEGER NOT NULL, "
+    "    tetrises INTEGER NOT NULL, "
+    "    PRIMARY KEY (playerId, mode, section, scoreId), "
+    "    FOREIGN KEY(scoreId) REFERENCES scores(scoreId) "
+    ") WITHOUT ROWID; "
+    "CREATE TABLE bestSplits ("
+    "    playerId INTEGER NOT NULL, "
+    "    mode INTEGER NOT NULL, "
+    "    section INTEGER NOT NULL, "
+    "    scoreId INTEGER NOT NULL, "
+    "    time INTEGER NOT NULL, "
+    "    tetrises INTEGER NOT NULL, "
+    "    PRIMARY KEY (playerId, mode, section), "
+    "    FOREIGN KEY(scoreId) REFERENCES scores(scoreId) "
+    ") WITHOUT ROWID; "
+    "CREATE TRIGGER updateBestSplit AFTER INSERT ON splits "
+    "BEGIN "
+    "    INSERT INTO bestSplits (playerId, mode, section, scoreId, time, tetrises) "
+    "        VALUES (NEW.playerId, NEW.mode, NEW.section, NEW.scoreId, NEW.time, NEW.tetrises) "
+    "    ON CONFLICT (playerId, mode, section) DO UPDATE SET "
+    "        scoreId = excluded.scoreId, time = excluded.time, tetrises = excluded.tetrises "
+    "    WHERE excluded.time < time; "
+    "END;"
+};
+
+static const std::size_t numMigrations = sizeof(migrations) / sizeof(migrations[0]);
+
+using Statement = Shiro::RecordList::Statement;
+using Parameter = Shiro::RecordList::Parameter;
+
+// indexed by Statement
+static const char *const statementSql[] = {
+    // insertPlayer
+    "INSERT OR IGNORE INTO players (name)"
+    "VALUES (:playerName);",
+
+    // selectPlayer
+    "SELECT playerId, name, tetroCount, pentoCount, tetrisCount "
+    "FROM players "
+    "WHERE name = :playerName;",
+
+    // updatePlayer
+    "UPDATE players "
+    "    SET tetroCount = :tetroCount, "
+    "        pentoCount = :pentoCount, "
+    "       tetrisCount = :tetrisCount "
+    "WHERE playerId = :playerId;",
+
+    // insertScore
+    "INSERT INTO scores (mode, playerId, grade, startLevel, level, time, date) "
+    "VALUES (:mode, :playerId, :grade, :startLevel, :level, :time, strftime('%s', 'now'));",
+
+    // insertReplay
+    "INSERT INTO replays (scoreId, replay) "
+    "VALUES (:scoreId, :replay);",
+
+    // countScores
+    "SELECT COUNT(*) "
+    "FROM scores "
+    "WHERE playerId = :playerId;",
+
+    // firstReplayPage; scoreId breaks ties, so every replay has a distinct position to continue after
+    "SELECT scoreId, mode, grade, startLevel, level, time, date "
+    "FROM scores "
+    "WHERE playerId = :playerId "
+    "ORDER BY mode, level DESC, time, scoreId "
+    "LIMIT :limit;",
+
+    // nextReplayPage; everything after a key in list order is four disjoint ranges of scoresByPlayer, each in list
+    // order already. As one OR, level's descending order stops SQLite seeking past mode, so it would scan from the
+    // start of the mode; apart, each range is a seek and at most :limit rows.
+    "SELECT * FROM ("
+    "    SELECT scoreId, mode, grade, startLevel, level, time, date FROM scores "
+    "    WHERE playerId = :playerId AND mode = :mode AND level = :level AND time = :time AND scoreId > :scoreId "
+    "    ORDER BY scoreId LIMIT :limit) "
+    "UNION ALL SELECT * FROM ("
+    "    SELECT scoreId, mode, grade, startLevel, level, time, date FROM scores "
+    "    WHERE playerId = :playerId AND mode = :mode AND level = :level AND time > :time "
+    "    ORDER BY time, scoreId LIMIT :limit) "
+    "UNION ALL SELECT * FROM ("
+    "    SELECT scoreId, mode, grade, startLevel, level, time, date FROM scores "
+    "    WHERE playerId = :playerId AND mode = :mode AND level < :level "
+    "    ORDER BY level DESC, time, scoreId LIMIT :limit) "
+    "UNION ALL SELECT * FROM ("
+    "    SELECT scoreId, mode, grade, startLevel, level, time, date FROM scores "
+    "    WHERE playerId = :playerId AND mode > :mode "
+    "    ORDER BY mode, level DESC, time, scoreId LIMIT :limit) "
+    "ORDER BY mode, level DESC, time, scoreId "
+    "LIMIT :limit;",
+
+    // bestScoreForMode; the best score is the best of the personal bests
+    "SELECT scoreId FROM personalBests "
+    "WHERE mode = :mode "
+    "ORDER BY grade DESC, level DESC, time, date "
+    "LIMIT 1;",
+
+    // personalBests
+    "SELECT scoreId, mode, grade, startLevel, level, time, date "
+    "FROM personalBests "
+    "WHERE playerId = :playerId "
+    "ORDER BY mode;",
+
+    // leaderboard
+    "SELECT players.name, scoreId, mode, grade, startLevel, level, time, date "
+    "FROM personalBests JOIN players USING (playerId) "
+    "WHERE mode = :mode "
+    "ORDER BY grade DESC, level DESC, time, date "
+    "LIMIT :limit;",
+
+    // nextScore
+    "SELECT scoreId, mode, grade, startLevel, level, time, date "
+    "FROM scores "
+    "WHERE scoreId > :scoreId "
+    "ORDER BY scoreId "
+    "LIMIT 1;",
+
+    // insertSplit
+    "INSERT INTO splits (playerId, mode, section, scoreId, time, tetrises) "
+    "VALUES (:playerId, :mode, :section, :scoreId, :time, :tetrises);",
+
+    // bestSplits
+    "SELECT scoreId, section, time, tetrises "
+    "FROM bestSplits "
+    "WHERE playerId = :playerId AND mode = :mode "
+    "ORDER BY section;",
+
+    // sectionTrend
+    "SELECT scoreId, section, time, tetrises "
+    "FROM splits "
+    "WHERE playerId = :playerId AND mode = :mode AND section = :section "
+    "ORDER BY scoreId DESC "
+    "LIMIT :limit;"
+};
+
+// indexed by Parameter
+static const char *const parameterNames[] = {
+    ":playerName",
+    ":playerId",
+    ":tetroCount",
+    ":pentoCount",
+    ":tetrisCount",
+    ":mode",
+    ":grade",
+    ":startLevel",
+    ":level",
+    ":time",
+    ":replay",
+    ":scoreId",
+    ":limit",
+    ":section",
+    ":tetrises"
+};
+
+static_assert(sizeof(statementSql) / sizeof(statementSql[0]) == Shiro::RecordList::numStatements, "every statement needs its SQL");
+static_assert(sizeof(parameterNames) / sizeof(parameterNames[0]) == Shiro::RecordList::numParameters, "every parameter needs its name");
+
+namespace {
+    /**
+     * One of a record list's cached statements, borrowed for one call:
+     * prepares the statement if this is its first use, and resets it and
+     * clears its bindings when the call is done with it, whether or not a
+     * check failed along the way.
+     */
+    class CachedStatement {
+    public:
+        CachedStatement(Shiro::RecordList *records, Statement statement);
+        ~CachedStatement();
+
+        CachedStatement(const CachedStatement&) = delete;
+        CachedStatement& operator=(const CachedStatement&) = delete;
+
+        operator sqlite3_stmt *() const;
+
+        int index(Parameter parameter) const;
+
+    private:
+        sqlite3_stmt *sql;
+        const std::array<int, Shiro::RecordList::numParameters> *indices;
+    };
+
+    CachedStatement::CachedStatement(Shiro::RecordList *records, Statement statement) {
+        const std::size_t s = static_cast<std::size_t>(statement);
+        sqlite3_stmt *&cached = records->statements[s];
+        if (!cached) {
+            check(sqlite3_prepare_v3(records->db, statementSql[s], -1, SQLITE_PREPARE_PERSISTENT, &cached, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
+            for (std::size_t p = 0; p < Shiro::RecordList::numParameters; p++) {
+                records->parameterIndices[s][p] = sqlite3_bind_parameter_index(cached, parameterNames[p]);
+            }
+        }
+        sql = cached;
+        indices = &records->parameterIndices[s];
+    }
+
+    CachedStatement::~CachedStatement() {
+        sqlite3_reset(sql);
+        sqlite3_clear_bindings(sql);
+    }
+
+    CachedStatement::operator sqlite3_stmt *() const {
+        return sql;
+    }
+
+    int CachedStatement::index(Parameter parameter) const {
+        return (*indices)[static_cast<std::size_t>(parameter)];
+    }
+}
+
+// Reads the columns scoreId, mode, grade, startLevel, level, time, date, in that order, starting at column `first`.
+static Shiro::ReplayDescriptor read_descriptor(sqlite3_stmt *sql, int first)
+{
+    Shiro::ReplayDescriptor descriptor;
+    descriptor.scoreId       = sqlite3_column_int(sql,   first + 0);
+    descriptor.mode          = sqlite3_column_int(sql,   first + 1);
+    descriptor.grade         = sqlite3_column_int(sql,   first + 2);
+    descriptor.startingLevel = sqlite3_column_int(sql,   first + 3);
+    descriptor.endingLevel   = sqlite3_column_int(sql,   first + 4);
+    descriptor.time          = sqlite3_column_int64(sql, first + 5);
+    descriptor.date          = sqlite3_column_int64(sql, first + 6);
+    return descriptor;
+}
+
+// Reads a score's raw replay with incremental blob I/O, straight from the replays table's row, without stepping a
+// statement. Returns false if the score has no replay or it can't be read.
+static bool read_replay_blob(Shiro::RecordList *records, int score_id, std::vector<uint8_t> *out_data)
+{
+    sqlite3_blob *blob;
+    if (sqlite3_blob_open(records->db, "main", "replays", "replay", score_id, 0, &blob) != SQLITE_OK) {
+        return false;
+    }
+
+    out_data->resize(std::size_t(sqlite3_blob_bytes(blob)));
+    const int ret = sqlite3_blob_read(blob, out_data->data(), int(out_data->size()), 0);
+    sqlite3_blob_close(blob);
+
+    return ret == SQLITE_OK;
+}
+
+// false if it couldn't be read; an empty schemaVersion table is version 0
+static bool read_schema_version(sqlite3 *db, std::size_t *version)
+{
+    const char getSchemaVersionSql[] =
+        "SELECT MAX(version) FROM schemaVersion;";
+
+    sqlite3_stmt *sql;
+    if (sqlite3_prepare_v2(db, getSchemaVersionSql, -1, &sql, NULL) != SQLITE_OK) {
+        return false;
+    }
+    const int ret = sqlite3_step(sql);
+    if (ret == SQLITE_ROW) {
+        *version = std::size_t(sqlite3_column_int64(sql, 0));
+    }
+    sqlite3_finalize(sql);
+    return ret == SQLITE_ROW;
+}
+
 void scoredb_init(Shiro::RecordList *records, const char *filename)
 {
+    // scoredb_create doesn't construct the record list
+    records->db = nullptr;
+    records->statements.fill(nullptr);
+
     try {
         int ret = sqlite3_open_v2(filename, &records->db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
         check(ret == SQLITE_OK, "Could not open/create sqlite database: %s", sqlite3_errmsg(records->db));
 
+        // two connections writing at once (the game's and a RecordWriter's) wait their turn rather than fail
+        sqlite3_busy_timeout(records->db, 5000);
+
         const char enableForeignKeysSql[] =
             "PRAGMA foreign_keys = ON;";
 
         ret = sqlite3_exec(records->db, enableForeignKeysSql, NULL, NULL, NULL);
         check(ret == 0, "Could not enable foreign key constraints");
 
-        const char createPlayerDbSql[] =
-            "CREATE TABLE IF NOT EXISTS players ("
-            "    playerId INTEGER PRIMARY KEY, "
-            "    name VARCHAR(64) UNIQUE NOT NULL COLLATE NOCASE, "
-            "    tetroCount INTEGER DEFAULT(0), "
-            "    pentoCount INTEGER DEFAULT(0), "
-            "    tetrisCount INTEGER DEFAULT(0)"
-            ");";
+        // the game reads on one connection while a RecordWriter writes on another; in WAL mode, neither waits for
+        // the other
+        const char enableWalSql[] =
+            "PRAGMA journal_mode = WAL;";
+
+        ret = sqlite3_exec(records->db, enableWalSql, NULL, NULL, NULL);
+        check(ret == 0, "Could not enable write-ahead logging: %s", sqlite3_errmsg(records->db));
 
-        ret = sqlite3_exec(records->db, createPlayerDbSql, NULL, NULL, NULL);
-        check(ret == 0, "Could not create players table: %s", sqlite3_errmsg(records->db));
-
-        // TODO: Actually design the database. Replay table? Player table + related columns? Indexes?
-        const char createTableSql[] =
-            "CREATE TABLE IF NOT EXISTS scores ("
-            "    scoreId INTEGER PRIMARY KEY, "
-            "    playerId INTEGER NOT NULL, "
-            "    mode INTEGER, "
-            "    grade INTEGER, "
-            "    startlevel INTEGER, "
-            "    level INTEGER, "
-            "    time INTEGER, "
-            "    replay BLOB, "
-            "    date INTEGER, "
-            "    FOREIGN KEY(playerId) REFERENCES players(playerId) "
+        const char createSchemaVersionSql[] =
+            "CREATE TABLE IF NOT EXISTS schemaVersion ("
+            "    version INTEGER NOT NULL"
             ");";
 
-        ret = sqlite3_exec(records->db, createTableSql, NULL, NULL, NULL);
-        check(ret == 0, "Could not create scores table");
+        ret = sqlite3_exec(records->db, createSchemaVersionSql, NULL, NULL, NULL);
+        check(ret == 0, "Could not create schemaVersion table: %s", sqlite3_errmsg(records->db));
+
+        std::size_t version;
+        check(read_schema_version(records->db, &version), "Could not read schema version: %s", sqlite3_errmsg(records->db));
+        check(version <= numMigrations, "Record list \"%s\" has schema version %zu, but this version of the game only knows up to %zu", filename, version, numMigrations);
+
+        while (version < numMigrations) {
+            // another process opening the same record list might be migrating it too; IMMEDIATE takes the write
+            // lock before the version is read again, so a step the other process got to first is skipped
+            ret = sqlite3_exec(records->db, "BEGIN IMMEDIATE;", NULL, NULL, NULL);
+            check(ret == SQLITE_OK, "Could not begin migration: %s", sqlite3_errmsg(records->db));
+
+            std::size_t current = version;
+            const bool reread = read_schema_version(records->db, &current);
+            if (reread && current != version) {
+                sqlite3_exec(records->db, "ROLLBACK;", NULL, NULL, NULL);
+                version = current;
+                check(version <= numMigrations, "Record list \"%s\" has schema version %zu, but this version of the game only knows up to %zu", filename, version, numMigrations);
+                continue;
+            }
+
+            const std::string setSchemaVersionSql =
+                "DELETE FROM schemaVersion; "
+                "INSERT INTO schemaVersion (version) VALUES (" + std::to_string(version + 1) + ");";
+
+            const bool migrated =
+                reread &&
+                sqlite3_exec(records->db, migrations[version], NULL, NULL, NULL) == SQLITE_OK &&
+                sqlite3_exec(records->db, setSchemaVersionSql.c_str(), NULL, NULL, NULL) == SQLITE_OK &&
+                sqlite3_exec(records->db, "COMMIT;", NULL, NULL, NULL) == SQLITE_OK;
+            if (!migrated) {
+                const std::string error = sqlite3_errmsg(records->db);
+                sqlite3_exec(records->db, "ROLLBACK;", NULL, NULL, NULL);
+                check(false, "Could not migrate record list to schema version %zu: %s", version + 1, error.c_str());
+            }
+
+            version++;
+            std::cerr << "Migrated record list \"" << filename << "\" to schema version " << version << std::endl;
+        }
 
         std::cerr << "Opened record list \"" << filename << "\"" << std::endl;
 
@@ -64,7 +468,13 @@ void scoredb_init(Shiro::RecordList *records, const char *filename)
 
 void scoredb_terminate(Shiro::RecordList *records)
 {
+    // the database can't be closed while it has statements
+    for (sqlite3_stmt *&sql : records->statements) {
+        sqlite3_finalize(sql);
+        sql = nullptr;
+    }
     sqlite3_close(records->db);
+    records->db = nullptr;
 }
 
 Shiro::RecordList *scoredb_create(const char *filename)
@@ -84,37 +494,28 @@ void scoredb_destroy(Shiro::RecordList *records)
 
 void scoredb_create_player(Shiro::RecordList *records, Shiro::Player *out_player, const char *playerName)
 {
-    sqlite3_stmt *sql;
     try {
-        const char insertPlayerSql[] =
-            "INSERT OR IGNORE INTO players (name)"
-            "VALUES (:playerName);";
-
-        check(sqlite3_prepare_v2(records->db, insertPlayerSql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
-
         size_t playerNameLength = 0;
         while (playerName[playerNameLength] != '\0' && ++playerNameLength < MAX_PLAYER_NAME_LENGTH);
 
         check(playerName != NULL && playerNameLength > 0, "Player name is invalid");
-        check_bind(records->db, sqlite3_bind_text(sql,  sqlite3_bind_parameter_index(sql, ":playerName"), playerName, (int)playerNameLength, SQLITE_STATIC));
 
-        int ret = sqlite3_step(sql);
-        check(ret == SQLITE_DONE, "Could not insert value into players table: %s", sqlite3_errmsg(records->db));
+        {
+            CachedStatement sql(records, Statement::insertPlayer);
 
-        std::cerr << "Player \"" << playerName << "\" is in players table" << std::endl;
+            check_bind(records->db, sqlite3_bind_text(sql,  sql.index(Parameter::playerName), playerName, (int)playerNameLength, SQLITE_STATIC));
 
-        sqlite3_finalize(sql);
+            int ret = sqlite3_step(sql);
+            check(ret == SQLITE_DONE, "Could not insert value into players table: %s", sqlite3_errmsg(records->db));
 
-        const char selectPlayerSql[] =
-            "SELECT playerId, name, tetroCount, pentoCount, tetrisCount "
-            "FROM players "
-            "WHERE name = :playerName;";
+            std::cerr << "Player \"" << playerName << "\" is in players table" << std::endl;
+        }
 
-        check(sqlite3_prepare_v2(records->db, selectPlayerSql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
+        CachedStatement sql(records, Statement::selectPlayer);
 
-        check_bind(records->db, sqlite3_bind_text(sql,  sqlite3_bind_parameter_index(sql, ":playerName"), playerName, (int)playerNameLength, SQLITE_STATIC));
+        check_bind(records->db, sqlite3_bind_text(sql,  sql.index(Parameter::playerName), playerName, (int)playerNameLength, SQLITE_STATIC));
 
-        ret = sqlite3_step(sql);
+        int ret = sqlite3_step(sql);
         check(ret == SQLITE_ROW, "Could not get player \"%s\" from players table: %s", playerName, sqlite3_errmsg(records->db));
 
         out_player->playerId    = sqlite3_column_int(sql,  0);
@@ -125,85 +526,100 @@ void scoredb_create_player(Shiro::RecordList *records, Shiro::Player *out_player
     }
     catch (const std::logic_error& error) {
     }
-
-    sqlite3_finalize(sql);
 }
 
 void scoredb_update_player(Shiro::RecordList *records, Shiro::Player *p)
 {
-    sqlite3_stmt *sql;
     try {
-        const char updatePlayerSql[] =
-            "UPDATE players "
-            "    SET tetroCount = :tetroCount, "
-            "        pentoCount = :pentoCount, "
-            "       tetrisCount = :tetrisCount "
-            "WHERE playerId = :playerId;";
+        CachedStatement sql(records, Statement::updatePlayer);
 
-        check(sqlite3_prepare_v2(records->db, updatePlayerSql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
-
-        check_bind(records->db, sqlite3_bind_int(sql, sqlite3_bind_parameter_index(sql, ":tetroCount"), p->tetroCount));
-        check_bind(records->db, sqlite3_bind_int(sql, sqlite3_bind_parameter_index(sql, ":pentoCount"), p->pentoCount));
-        check_bind(records->db, sqlite3_bind_int(sql, sqlite3_bind_parameter_index(sql, ":tetrisCount"), p->tetrisCount));
-        check_bind(records->db, sqlite3_bind_int(sql, sqlite3_bind_parameter_index(sql, ":playerId"), p->playerId));
+        check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::tetroCount), p->tetroCount));
+        check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::pentoCount), p->pentoCount));
+        check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::tetrisCount), p->tetrisCount));
+        check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::playerId), p->playerId));
 
         const int ret = sqlite3_step(sql);
         check(ret == SQLITE_DONE, "Could not update players table for: %s", sqlite3_errmsg(records->db));
     }
     catch (const std::logic_error& error) {
     }
-
-    sqlite3_finalize(sql);
 }
 
-void scoredb_add(Shiro::RecordList *records, Shiro::Player* p, struct replay *r)
+void scoredb_add(Shiro::RecordList *records, Shiro::Player* p, struct replay *r, const std::vector<Shiro::SectionSplit> &splits)
 {
-    sqlite3_stmt *sql;
+    size_t replayLen = 0;
+    uint8_t *replayData = NULL;
+    bool adding = false;
     try {
         std::string replayDescriptor = get_replay_descriptor(r);
 
-        const char insertSql[] =
-            "INSERT INTO scores (mode, playerId, grade, startLevel, level, time, replay, date) "
-            "VALUES (:mode, :playerId, :grade, :startLevel, :level, :time, :replay, strftime('%s', 'now'));";
+        replayData = generate_raw_replay(r, &replayLen);
 
-        check(sqlite3_prepare_v2(records->db, insertSql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
+        // the score and its replay are added together or not at all; a savepoint, as the caller might be in a transaction
+        check(sqlite3_exec(records->db, "SAVEPOINT addScore;", NULL, NULL, NULL) == SQLITE_OK, "Could not begin adding score: %s", sqlite3_errmsg(records->db));
+        adding = true;
 
-        size_t replayLen = 0;
-        uint8_t *replayData = generate_raw_replay(r, &replayLen);
+        {
+            CachedStatement sql(records, Statement::insertScore);
 
-        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":mode"),       r->mode));
-        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":playerId"),   p->playerId));
-        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":grade"),      r->grade));
-        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":startLevel"), r->starting_level));
-        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":level"),      r->ending_level));
-        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":time"),       int(r->time)));
-        check_bind(records->db, sqlite3_bind_blob(sql, sqlite3_bind_parameter_index(sql, ":replay"),     replayData, (int)replayLen, SQLITE_STATIC));
+            check_bind(records->db, sqlite3_bind_int(sql,  sql.index(Parameter::mode),       r->mode));
+            check_bind(records->db, sqlite3_bind_int(sql,  sql.index(Parameter::playerId),   p->playerId));
+            check_bind(records->db, sqlite3_bind_int(sql,  sql.index(Parameter::grade),      r->grade));
+            check_bind(records->db, sqlite3_bind_int(sql,  sql.index(Parameter::startLevel), r->starting_level));
+            check_bind(records->db, sqlite3_bind_int(sql,  sql.index(Parameter::level),      r->ending_level));
+            check_bind(records->db, sqlite3_bind_int(sql,  sql.index(Parameter::time),       int(r->time)));
 
-        const int ret = sqlite3_step(sql);
-        check(ret == SQLITE_DONE, "Could not insert value into scores table: %s", sqlite3_errmsg(records->db));
-        dispose_raw_replay(replayData);
+            const int ret = sqlite3_step(sql);
+            check(ret == SQLITE_DONE, "Could not insert value into scores table: %s", sqlite3_errmsg(records->db));
+        }
+
+        const sqlite3_int64 scoreId = sqlite3_last_insert_rowid(records->db);
+
+        {
+            CachedStatement sql(records, Statement::insertReplay);
+
+            check_bind(records->db, sqlite3_bind_int64(sql, sql.index(Parameter::scoreId), scoreId));
+            check_bind(records->db, sqlite3_bind_blob(sql,  sql.index(Parameter::replay),  replayData, (int)replayLen, SQLITE_STATIC));
+
+            const int ret = sqlite3_step(sql);
+            check(ret == SQLITE_DONE, "Could not insert value into replays table: %s", sqlite3_errmsg(records->db));
+        }
+
+        for (const Shiro::SectionSplit &split : splits) {
+            CachedStatement sql(records, Statement::insertSplit);
+
+            check_bind(records->db, sqlite3_bind_int(sql,   sql.index(Parameter::playerId), p->playerId));
+            check_bind(records->db, sqlite3_bind_int(sql,   sql.index(Parameter::mode),     r->mode));
+            check_bind(records->db, sqlite3_bind_int(sql,   sql.index(Parameter::section),  split.section));
+            check_bind(records->db, sqlite3_bind_int64(sql, sql.index(Parameter::scoreId),  scoreId));
+            check_bind(records->db, sqlite3_bind_int(sql,   sql.index(Parameter::time),     split.time));
+            check_bind(records->db, sqlite3_bind_int(sql,   sql.index(Parameter::tetrises), split.tetrises));
+
+            const int ret = sqlite3_step(sql);
+            check(ret == SQLITE_DONE, "Could not insert value into splits table: %s", sqlite3_errmsg(records->db));
+        }
+
+        check(sqlite3_exec(records->db, "RELEASE addScore;", NULL, NULL, NULL) == SQLITE_OK, "Could not finish adding score: %s", sqlite3_errmsg(records->db));
+        adding = false;
 
         std::cerr << "Wrote replay " << replayLen << ": " << replayDescriptor << std::endl;
     }
     catch (const std::logic_error& error) {
+        if (adding) {
+            sqlite3_exec(records->db, "ROLLBACK TO addScore; RELEASE addScore;", NULL, NULL, NULL);
+        }
     }
 
-    sqlite3_finalize(sql);
+    dispose_raw_replay(replayData);
 }
 
 int scoredb_get_replay_count(Shiro::RecordList *records, Shiro::Player *p)
 {
-    sqlite3_stmt *sql;
     int replayCount = 0;
     try {
-        const char getReplayCountSql[] =
-            "SELECT COUNT(*) "
-            "FROM scores "
-            "WHERE playerId = :playerId;";
+        CachedStatement sql(records, Statement::countScores);
 
-        check(sqlite3_prepare_v2(records->db, getReplayCountSql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
-
-        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":playerId"), p->playerId));
+        check_bind(records->db, sqlite3_bind_int(sql,  sql.index(Parameter::playerId), p->playerId));
 
         const int ret = sqlite3_step(sql);
         check(ret == SQLITE_ROW, "Could not get replay count: %s", sqlite3_errmsg(records->db));
@@ -213,102 +629,214 @@ int scoredb_get_replay_count(Shiro::RecordList *records, Shiro::Player *p)
     catch (const std::logic_error& error) {
     }
 
-    sqlite3_finalize(sql);
-
     return replayCount;
 }
 
-struct replay *scoredb_get_replay_list(Shiro::RecordList *records, Shiro::Player *p, int *out_replayCount)
+std::vector<Shiro::ReplayDescriptor> scoredb_get_replay_page(Shiro::RecordList *records, Shiro::Player *p, const Shiro::ReplayDescriptor *after, int limit)
 {
-    sqlite3_stmt *sql;
-    const std::size_t replayCount = scoredb_get_replay_count(records, p);
-    struct replay *replayList = new struct replay[replayCount];
-    assert(replayList != nullptr);
+    std::vector<Shiro::ReplayDescriptor> page;
     try {
-        // TODO: Pagination? Current interface expects a full list of replays
-        const char getReplayListSql[] =
-            "SELECT scoreId, mode, grade, startLevel, level, time, date "
-            "FROM scores "
-            "WHERE playerId = :playerId "
-            "ORDER BY mode, level DESC, time;";
+        CachedStatement sql(records, after ? Statement::nextReplayPage : Statement::firstReplayPage);
+
+        check_bind(records->db, sqlite3_bind_int(sql,  sql.index(Parameter::playerId), p->playerId));
+        check_bind(records->db, sqlite3_bind_int(sql,  sql.index(Parameter::limit),    limit));
+        if (after) {
+            check_bind(records->db, sqlite3_bind_int(sql,   sql.index(Parameter::mode),    after->mode));
+            check_bind(records->db, sqlite3_bind_int(sql,   sql.index(Parameter::level),   after->endingLevel));
+            check_bind(records->db, sqlite3_bind_int64(sql, sql.index(Parameter::time),    sqlite3_int64(after->time)));
+            check_bind(records->db, sqlite3_bind_int(sql,   sql.index(Parameter::scoreId), after->scoreId));
+        }
+
+        page.reserve(limit > 0 ? limit : 0);
+
+        int ret;
+        while ((ret = sqlite3_step(sql)) == SQLITE_ROW)
+        {
+            page.push_back(read_descriptor(sql, 0));
+        }
+        check(ret == SQLITE_DONE, "Could not get replay: %s", sqlite3_errmsg(records->db));
+    }
+    catch (const std::logic_error& error) {
+    }
+
+    return page;
+}
 
-        check(sqlite3_prepare_v2(records->db, getReplayListSql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
+std::vector<Shiro::ReplayDescriptor> scoredb_get_personal_bests(Shiro::RecordList *records, Shiro::Player *p)
+{
+    std::vector<Shiro::ReplayDescriptor> bests;
+    try {
+        CachedStatement sql(records, Statement::personalBests);
 
-        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":playerId"), p->playerId));
+        check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::playerId), p->playerId));
 
-        for (std::size_t i = 0; i < replayCount; i++)
+        int ret;
+        while ((ret = sqlite3_step(sql)) == SQLITE_ROW)
         {
-            int ret = sqlite3_step(sql);
-            check(ret == SQLITE_ROW, "Could not get replay: %s", sqlite3_errmsg(records->db));
+            bests.push_back(read_descriptor(sql, 0));
+        }
+        check(ret == SQLITE_DONE, "Could not get personal bests: %s", sqlite3_errmsg(records->db));
+    }
+    catch (const std::logic_error& error) {
+    }
+
+    return bests;
+}
+
+std::vector<Shiro::LeaderboardEntry> scoredb_get_leaderboard(Shiro::RecordList *records, int mode, int limit)
+{
+    std::vector<Shiro::LeaderboardEntry> leaderboard;
+    try {
+        CachedStatement sql(records, Statement::leaderboard);
+
+        check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::mode),  mode));
+        check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::limit), limit));
 
-            replayList[i].index          = sqlite3_column_int(sql, 0);
-            replayList[i].mode           = sqlite3_column_int(sql, 1);
-            replayList[i].grade          = sqlite3_column_int(sql, 2);
-            replayList[i].starting_level = sqlite3_column_int(sql, 3);
-            replayList[i].ending_level   = sqlite3_column_int(sql, 4);
-            replayList[i].time           = sqlite3_column_int(sql, 5);
-            replayList[i].date           = sqlite3_column_int(sql, 6);
+        leaderboard.reserve(limit > 0 ? limit : 0);
+
+        int ret;
+        while ((ret = sqlite3_step(sql)) == SQLITE_ROW)
+        {
+            const unsigned char *name = sqlite3_column_text(sql, 0);
+            leaderboard.push_back({ name ? reinterpret_cast<const char *>(name) : "", read_descriptor(sql, 1) });
         }
+        check(ret == SQLITE_DONE, "Could not get leaderboard: %s", sqlite3_errmsg(records->db));
     }
     catch (const std::logic_error& error) {
     }
-    sqlite3_finalize(sql);
 
-    *out_replayCount = int(replayCount);
-    return replayList;
+    return leaderboard;
 }
 
+// Reads the columns scoreId, section, time, tetrises, in that order.
+static Shiro::SectionSplit read_split(sqlite3_stmt *sql)
+{
+    Shiro::SectionSplit split;
+    split.scoreId  = sqlite3_column_int(sql, 0);
+    split.section  = sqlite3_column_int(sql, 1);
+    split.time     = sqlite3_column_int(sql, 2);
+    split.tetrises = sqlite3_column_int(sql, 3);
+    return split;
+}
 
-void scoredb_get_full_replay(Shiro::RecordList *records, struct replay *out_replay, int replay_id)
+std::vector<Shiro::SectionSplit> scoredb_get_best_splits(Shiro::RecordList *records, Shiro::Player *p, int mode)
 {
-    sqlite3_stmt *sql;
+    std::vector<Shiro::SectionSplit> splits;
     try {
-        const char *getReplaySql =
-            "SELECT replay FROM scores "
-            "WHERE scoreId = :scoreId;";
+        CachedStatement sql(records, Statement::bestSplits);
 
-        check(sqlite3_prepare_v2(records->db, getReplaySql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
+        check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::playerId), p->playerId));
+        check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::mode),     mode));
 
-        check_bind(records->db, sqlite3_bind_int(sql, sqlite3_bind_parameter_index(sql, ":scoreId"), replay_id));
+        int ret;
+        while ((ret = sqlite3_step(sql)) == SQLITE_ROW)
+        {
+            splits.push_back(read_split(sql));
+        }
+        check(ret == SQLITE_DONE, "Could not get best splits: %s", sqlite3_errmsg(records->db));
+    }
+    catch (const std::logic_error& error) {
+    }
 
-        const int ret = sqlite3_step(sql);
-        check(ret == SQLITE_ROW, "Could not get replay: %s", sqlite3_errmsg(records->db));
+    return splits;
+}
+
+uint64_t scoredb_get_best_possible_time(Shiro::RecordList *records, Shiro::Player *p, int mode)
+{
+    uint64_t time = 0;
+    for (const Shiro::SectionSplit &split : scoredb_get_best_splits(records, p, mode)) {
+        time += uint64_t(split.time);
+    }
+
+    return time;
+}
 
-        const int replayBufferLength = sqlite3_column_bytes(sql, 0);
-        const uint8_t *replayBuffer = (const uint8_t *)sqlite3_column_blob(sql, 0);
+std::vector<Shiro::SectionSplit> scoredb_get_section_trend(Shiro::RecordList *records, Shiro::Player *p, int mode, int section, int limit)
+{
+    std::vector<Shiro::SectionSplit> splits;
+    try {
+        CachedStatement sql(records, Statement::sectionTrend);
+
+        check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::playerId), p->playerId));
+        check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::mode),     mode));
+        check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::section),  section));
+        check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::limit),    limit));
 
-        read_replay_from_memory(out_replay, replayBuffer, replayBufferLength);
+        splits.reserve(limit > 0 ? limit : 0);
+
+        int ret;
+        while ((ret = sqlite3_step(sql)) == SQLITE_ROW)
+        {
+            splits.push_back(read_split(sql));
+        }
+        check(ret == SQLITE_DONE, "Could not get section trend: %s", sqlite3_errmsg(records->db));
     }
     catch (const std::logic_error& error) {
     }
 
-    sqlite3_finalize(sql);
+    return splits;
+}
+
+void scoredb_get_full_replay(Shiro::RecordList *records, struct replay *out_replay, int replay_id)
+{
+    try {
+        std::vector<uint8_t> replayBuffer;
+        check(read_replay_blob(records, replay_id, &replayBuffer), "Could not get replay %d: %s", replay_id, sqlite3_errmsg(records->db));
+
+        check(read_replay_from_memory(out_replay, replayBuffer.data(), replayBuffer.size()), "Could not read replay: malformed replay data");
+    }
+    catch (const std::logic_error& error) {
+    }
 }
 
 void scoredb_get_full_replay_by_condition(Shiro::RecordList *records, struct replay *out_replay, int mode)
 {
-    sqlite3_stmt *sql;
     try {
-        const char *getReplaySql =
-            "SELECT replay FROM scores "
-            "WHERE mode = :mode "
-            "ORDER BY grade DESC, level DESC, time, date "
-            "LIMIT 1;";
+        int scoreId;
+        {
+            CachedStatement sql(records, Statement::bestScoreForMode);
+
+            check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::mode), mode));
+
+            int ret = sqlite3_step(sql);
+            check(ret == SQLITE_ROW, "Could not get replay: %s", sqlite3_errmsg(records->db));
+
+            scoreId = sqlite3_column_int(sql, 0);
+        }
+
+        std::vector<uint8_t> replayBuffer;
+        check(read_replay_blob(records, scoreId, &replayBuffer), "Could not get replay %d: %s", scoreId, sqlite3_errmsg(records->db));
+
+        check(read_replay_from_memory(out_replay, replayBuffer.data(), replayBuffer.size()), "Could not read replay: malformed replay data");
+    }
+    catch (const std::logic_error& error) {
+    }
+}
+
+bool scoredb_get_next_raw_replay(Shiro::RecordList *records, int after_score_id, Shiro::ReplayDescriptor *out_descriptor, std::vector<uint8_t> *out_data)
+{
+    bool found = false;
+    try {
+        CachedStatement sql(records, Statement::nextScore);
 
-        check(sqlite3_prepare_v2(records->db, getReplaySql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
+        check_bind(records->db, sqlite3_bind_int(sql, sql.index(Parameter::scoreId), after_score_id));
 
-        check_bind(records->db, sqlite3_bind_int(sql, sqlite3_bind_parameter_index(sql, ":mode"), mode));
+        const int ret = sqlite3_step(sql);
+        check(ret == SQLITE_ROW || ret == SQLITE_DONE, "Could not get replay: %s", sqlite3_errmsg(records->db));
 
-        int ret = sqlite3_step(sql);
-        check(ret == SQLITE_ROW, "Could not get replay: %s", sqlite3_errmsg(records->db));
+        if (ret == SQLITE_ROW) {
+            *out_descriptor = read_descriptor(sql, 0);
 
-        int replayBufferLength = sqlite3_column_bytes(sql, 0);
-        const uint8_t *replayBuffer = (const uint8_t *)sqlite3_column_blob(sql, 0);
+            // a score without a replay still counts, with no replay data
+            if (!read_replay_blob(records, out_descriptor->scoreId, out_data)) {
+                out_data->clear();
+            }
 
-        read_replay_from_memory(out_replay, replayBuffer, replayBufferLength);
+            found = true;
+        }
     }
     catch (const std::logic_error& error) {
     }
 
-    sqlite3_finalize(sql);
-}
\ No newline at end of file
+    return found;
+}
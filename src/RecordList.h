@@ -1,13 +1,89 @@
 #pragma once
 #include "Player.h"
+#include "replay.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <sqlite3.h>
+#include <string>
+#include <vector>
 namespace Shiro {
     struct RecordList {
-        sqlite3 *db;
+        /**
+         * The statements the scoredb_* functions run. Each one is prepared
+         * the first time it's run, then kept until scoredb_terminate and
+         * reset after every use, so a call only binds and steps.
+         */
+        enum class Statement : std::size_t {
+            insertPlayer,
+            selectPlayer,
+            updatePlayer,
+            insertScore,
+            insertReplay,
+            countScores,
+            firstReplayPage,
+            nextReplayPage,
+            bestScoreForMode,
+            personalBests,
+            leaderboard,
+            nextScore,
+            insertSplit,
+            bestSplits,
+            sectionTrend,
+            count
+        };
+
+        /**
+         * Every named parameter of those statements.
+         */
+        enum class Parameter : std::size_t {
+            playerName,
+            playerId,
+            tetroCount,
+            pentoCount,
+            tetrisCount,
+            mode,
+            grade,
+            startLevel,
+            level,
+            time,
+            replay,
+            scoreId,
+            limit,
+            section,
+            tetrises,
+            count
+        };
+
+        static constexpr std::size_t numStatements = static_cast<std::size_t>(Statement::count);
+        static constexpr std::size_t numParameters = static_cast<std::size_t>(Parameter::count);
+
+        sqlite3 *db = nullptr;
+        std::array<sqlite3_stmt *, numStatements> statements{};
+        // the index of each parameter in each prepared statement, looked up when it's prepared; 0 if it has no such parameter
+        std::array<std::array<int, numParameters>, numStatements> parameterIndices{};
     };
-}
-struct replay;
 
+    /**
+     * A player's best score in a mode, as it places on that mode's
+     * leaderboard.
+     */
+    struct LeaderboardEntry {
+        std::string playerName;
+        ReplayDescriptor score;
+    };
+
+    /**
+     * One finished section of a game: how long it took, in frames, and how
+     * many tetrises were in it. The score ID is the game's.
+     */
+    struct SectionSplit {
+        int scoreId;
+        int section;
+        int time;
+        int tetrises;
+    };
+}
 void scoredb_init(Shiro::RecordList *records, const char *filename);
 void scoredb_terminate(Shiro::RecordList *records);
 
@@ -17,12 +93,38 @@ void scoredb_destroy(Shiro::RecordList *records);
 void scoredb_create_player(Shiro::RecordList *records, Shiro::Player *out_player, const char *playerName);
 void scoredb_update_player(Shiro::RecordList *records, Shiro::Player *p);
 
-void scoredb_add(Shiro::RecordList *records, Shiro::Player* p, struct replay *r);
+// Adds the replay's score and the splits of the sections the game finished; the splits' score IDs are ignored.
+void scoredb_add(Shiro::RecordList *records, Shiro::Player* p, struct replay *r, const std::vector<Shiro::SectionSplit> &splits);
 
 int scoredb_get_replay_count(Shiro::RecordList *records, Shiro::Player* p);
 
-// Get list of replay descriptors (no replay data)
-struct replay *scoredb_get_replay_list(Shiro::RecordList *records, Shiro::Player *p, int *out_replayCount);
+// Gets up to `limit` of the player's replay descriptors (no replay data), in replay list order: by mode, then
+// level descending, then time. The page starts after the descriptor `after` (keyset pagination, so deep pages
+// cost the same as the first), or at the start of the list if it's null.
+std::vector<Shiro::ReplayDescriptor> scoredb_get_replay_page(Shiro::RecordList *records, Shiro::Player *p, const Shiro::ReplayDescriptor *after, int limit);
+
+// Gets the player's best score in each mode they've played, by mode. Personal bests are kept up to date as scores
+// are added, so this reads one row per mode, however many games the player has played.
+std::vector<Shiro::ReplayDescriptor> scoredb_get_personal_bests(Shiro::RecordList *records, Shiro::Player *p);
+
+// Gets the mode's top `limit` players by their personal bests, best first: by grade, then level, then time, with
+// ties going to the older score.
+std::vector<Shiro::LeaderboardEntry> scoredb_get_leaderboard(Shiro::RecordList *records, int mode, int limit);
+
+// Gets the player's fastest split of each section they've finished in the mode, by section. Best splits are kept up
+// to date as scores are added, so this reads one row per section.
+std::vector<Shiro::SectionSplit> scoredb_get_best_splits(Shiro::RecordList *records, Shiro::Player *p, int mode);
+
+// Gets the player's best possible time in the mode: the sum of their best splits. 0 if they have none.
+uint64_t scoredb_get_best_possible_time(Shiro::RecordList *records, Shiro::Player *p, int mode);
+
+// Gets the player's latest `limit` splits of the section in the mode, newest first.
+std::vector<Shiro::SectionSplit> scoredb_get_section_trend(Shiro::RecordList *records, Shiro::Player *p, int mode, int section, int limit);
 
 void scoredb_get_full_replay(Shiro::RecordList *records, struct replay *out_replay, int replay_id);
-void scoredb_get_full_replay_by_condition(Shiro::RecordList *records, struct replay *out_replay, int mode);
\ No newline at end of file
+void scoredb_get_full_replay_by_condition(Shiro::RecordList *records, struct replay *out_replay, int mode);
+
+// Gets the first score after after_score_id in scoreId order, for walking the whole table: the stored results
+// go into out_descriptor and the undecoded replay into out_data, which is left empty if the score has no replay.
+// Returns false when there are no more scores.
+bool scoredb_get_next_raw_replay(Shiro::RecordList *records, int after_score_id, Shiro::ReplayDescriptor *out_descriptor, std::vector<uint8_t> *out_data);
\ No newline at end of file
@@ -0,0 +1,572 @@
+#include "RecordListBenchmark.h"
+#include "Debug.h"
+#include "game_qs.h"
+#include "Player.h"
+#include "RecordList.h"
+#include "replay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <sqlite3.h>
+#include <string>
+#include <system_error>
+#include <vector>
+#define check_bind(db, bind_call) check((bind_call) == SQLITE_OK, "Could not bind parameter value: %s", sqlite3_errmsg((db)))
+
+/* the scoredb_* functions as they were before RecordList cached its
+   statements, preparing every statement on every call; kept as the
+   reference the cached ones are timed against, with only their SQL kept
+   up to date with the schema; the replay page's is still the single-OR
+   keyset that SQLite can't seek past the mode on */
+static void reference_scoredb_add(Shiro::RecordList *records, Shiro::Player* p, struct replay *r)
+{
+    sqlite3_stmt *sql = NULL;
+    size_t replayLen = 0;
+    uint8_t *replayData = NULL;
+    bool adding = false;
+    try {
+        std::string replayDescriptor = get_replay_descriptor(r);
+
+        replayData = generate_raw_replay(r, &replayLen);
+
+        check(sqlite3_exec(records->db, "SAVEPOINT addScore;", NULL, NULL, NULL) == SQLITE_OK, "Could not begin adding score: %s", sqlite3_errmsg(records->db));
+        adding = true;
+
+        const char insertSql[] =
+            "INSERT INTO scores (mode, playerId, grade, startLevel, level, time, date) "
+            "VALUES (:mode, :playerId, :grade, :startLevel, :level, :time, strftime('%s', 'now'));";
+
+        check(sqlite3_prepare_v2(records->db, insertSql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
+
+        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":mode"),       r->mode));
+        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":playerId"),   p->playerId));
+        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":grade"),      r->grade));
+        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":startLevel"), r->starting_level));
+        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":level"),      r->ending_level));
+        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":time"),       int(r->time)));
+
+        int ret = sqlite3_step(sql);
+        check(ret == SQLITE_DONE, "Could not insert value into scores table: %s", sqlite3_errmsg(records->db));
+        sqlite3_finalize(sql);
+        sql = NULL;
+
+        const char insertReplaySql[] =
+            "INSERT INTO replays (scoreId, replay) "
+            "VALUES (:scoreId, :replay);";
+
+        check(sqlite3_prepare_v2(records->db, insertReplaySql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
+
+        check_bind(records->db, sqlite3_bind_int64(sql, sqlite3_bind_parameter_index(sql, ":scoreId"), sqlite3_last_insert_rowid(records->db)));
+        check_bind(records->db, sqlite3_bind_blob(sql,  sqlite3_bind_parameter_index(sql, ":replay"),  replayData, (int)replayLen, SQLITE_STATIC));
+
+        ret = sqlite3_step(sql);
+        check(ret == SQLITE_DONE, "Could not insert value into replays table: %s", sqlite3_errmsg(records->db));
+
+        check(sqlite3_exec(records->db, "RELEASE addScore;", NULL, NULL, NULL) == SQLITE_OK, "Could not finish adding score: %s", sqlite3_errmsg(records->db));
+        adding = false;
+
+        std::cerr << "Wrote replay " << replayLen << ": " << replayDescriptor << std::endl;
+    }
+    catch (const std::logic_error& error) {
+        if (adding) {
+            sqlite3_exec(records->db, "ROLLBACK TO addScore; RELEASE addScore;", NULL, NULL, NULL);
+        }
+    }
+
+    sqlite3_finalize(sql);
+    dispose_raw_replay(replayData);
+}
+
+static int reference_scoredb_get_replay_count(Shiro::RecordList *records, Shiro::Player *p)
+{
+    sqlite3_stmt *sql;
+    int replayCount = 0;
+    try {
+        const char getReplayCountSql[] =
+            "SELECT COUNT(*) "
+            "FROM scores "
+            "WHERE playerId = :playerId;";
+
+        check(sqlite3_prepare_v2(records->db, getReplayCountSql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
+
+        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":playerId"), p->playerId));
+
+        const int ret = sqlite3_step(sql);
+        check(ret == SQLITE_ROW, "Could not get replay count: %s", sqlite3_errmsg(records->db));
+
+        replayCount = sqlite3_column_int(sql, 0);
+    }
+    catch (const std::logic_error& error) {
+    }
+
+    sqlite3_finalize(sql);
+
+    return replayCount;
+}
+
+static std::vector<Shiro::ReplayDescriptor> reference_scoredb_get_replay_page(Shiro::RecordList *records, Shiro::Player *p, const Shiro::ReplayDescriptor *after, int limit)
+{
+    sqlite3_stmt *sql;
+    std::vector<Shiro::ReplayDescriptor> page;
+    try {
+        // scoreId breaks ties, so every replay has a distinct position to continue after
+        const char getFirstPageSql[] =
+            "SELECT scoreId, mode, grade, startLevel, level, time, date "
+            "FROM scores "
+            "WHERE playerId = :playerId "
+            "ORDER BY mode, level DESC, time, scoreId "
+            "LIMIT :limit;";
+
+        const char getNextPageSql[] =
+            "SELECT scoreId, mode, grade, startLevel, level, time, date "
+            "FROM scores "
+            "WHERE playerId = :playerId AND ("
+            "    mode > :mode OR (mode = :mode AND ("
+            "        level < :level OR (level = :level AND ("
+            "            time > :time OR (time = :time AND scoreId > :scoreId)))))) "
+            "ORDER BY mode, level DESC, time, scoreId "
+            "LIMIT :limit;";
+
+        check(sqlite3_prepare_v2(records->db, after ? getNextPageSql : getFirstPageSql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
+
+        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":playerId"), p->playerId));
+        check_bind(records->db, sqlite3_bind_int(sql,  sqlite3_bind_parameter_index(sql, ":limit"),    limit));
+        if (after) {
+            check_bind(records->db, sqlite3_bind_int(sql,   sqlite3_bind_parameter_index(sql, ":mode"),    after->mode));
+            check_bind(records->db, sqlite3_bind_int(sql,   sqlite3_bind_parameter_index(sql, ":level"),   after->endingLevel));
+            check_bind(records->db, sqlite3_bind_int64(sql, sqlite3_bind_parameter_index(sql, ":time"),    sqlite3_int64(after->time)));
+            check_bind(records->db, sqlite3_bind_int(sql,   sqlite3_bind_parameter_index(sql, ":scoreId"), after->scoreId));
+        }
+
+        page.reserve(limit > 0 ? limit : 0);
+
+        int ret;
+        while ((ret = sqlite3_step(sql)) == SQLITE_ROW)
+        {
+            Shiro::ReplayDescriptor descriptor;
+            descriptor.scoreId       = sqlite3_column_int(sql, 0);
+            descriptor.mode          = sqlite3_column_int(sql, 1);
+            descriptor.grade         = sqlite3_column_int(sql, 2);
+            descriptor.startingLevel = sqlite3_column_int(sql, 3);
+            descriptor.endingLevel   = sqlite3_column_int(sql, 4);
+            descriptor.time          = sqlite3_column_int64(sql, 5);
+            descriptor.date          = sqlite3_column_int64(sql, 6);
+            page.push_back(descriptor);
+        }
+        check(ret == SQLITE_DONE, "Could not get replay: %s", sqlite3_errmsg(records->db));
+    }
+    catch (const std::logic_error& error) {
+    }
+    sqlite3_finalize(sql);
+
+    return page;
+}
+
+static void reference_scoredb_get_full_replay(Shiro::RecordList *records, struct replay *out_replay, int replay_id)
+{
+    sqlite3_stmt *sql;
+    try {
+        const char *getReplaySql =
+            "SELECT replay FROM replays "
+            "WHERE scoreId = :scoreId;";
+
+        check(sqlite3_prepare_v2(records->db, getReplaySql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
+
+        check_bind(records->db, sqlite3_bind_int(sql, sqlite3_bind_parameter_index(sql, ":scoreId"), replay_id));
+
+        const int ret = sqlite3_step(sql);
+        check(ret == SQLITE_ROW, "Could not get replay: %s", sqlite3_errmsg(records->db));
+
+        const int replayBufferLength = sqlite3_column_bytes(sql, 0);
+        const uint8_t *replayBuffer = (const uint8_t *)sqlite3_column_blob(sql, 0);
+
+        check(read_replay_from_memory(out_replay, replayBuffer, replayBufferLength), "Could not read replay: malformed replay data");
+    }
+    catch (const std::logic_error& error) {
+    }
+
+    sqlite3_finalize(sql);
+}
+
+/* personal bests and leaderboards were added with the tables that keep them
+   up to date, so there's no earlier version to compare against; these
+   work them out from every score instead, by brute force */
+static Shiro::ReplayDescriptor read_reference_descriptor(sqlite3_stmt *sql, int first)
+{
+    Shiro::ReplayDescriptor descriptor;
+    descriptor.scoreId       = sqlite3_column_int(sql, first);
+    descriptor.mode          = sqlite3_column_int(sql, first + 1);
+    descriptor.grade         = sqlite3_column_int(sql, first + 2);
+    descriptor.startingLevel = sqlite3_column_int(sql, first + 3);
+    descriptor.endingLevel   = sqlite3_column_int(sql, first + 4);
+    descriptor.time          = sqlite3_column_int64(sql, first + 5);
+    descriptor.date          = sqlite3_column_int64(sql, first + 6);
+    return descriptor;
+}
+
+static std::vector<Shiro::ReplayDescriptor> reference_scoredb_get_personal_bests(Shiro::RecordList *records, Shiro::Player *p)
+{
+    sqlite3_stmt *sql;
+    std::vector<Shiro::ReplayDescriptor> bests;
+    try {
+        // a player's best in a mode is their first score that no later one beat
+        const char getPersonalBestsSql[] =
+            "SELECT scoreId, mode, grade, startLevel, level, time, date FROM ("
+            "    SELECT *, row_number() OVER ("
+            "        PARTITION BY mode ORDER BY grade DESC, level DESC, time, scoreId) AS rank "
+            "    FROM scores "
+            "    WHERE playerId = :playerId) "
+            "WHERE rank = 1 "
+            "ORDER BY mode;";
+
+        check(sqlite3_prepare_v2(records->db, getPersonalBestsSql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
+
+        check_bind(records->db, sqlite3_bind_int(sql, sqlite3_bind_parameter_index(sql, ":playerId"), p->playerId));
+
+        int ret;
+        while ((ret = sqlite3_step(sql)) == SQLITE_ROW)
+        {
+            bests.push_back(read_reference_descriptor(sql, 0));
+        }
+        check(ret == SQLITE_DONE, "Could not get personal bests: %s", sqlite3_errmsg(records->db));
+    }
+    catch (const std::logic_error& error) {
+    }
+    sqlite3_finalize(sql);
+
+    return bests;
+}
+
+static std::vector<Shiro::LeaderboardEntry> reference_scoredb_get_leaderboard(Shiro::RecordList *records, int mode, int limit)
+{
+    sqlite3_stmt *sql;
+    std::vector<Shiro::LeaderboardEntry> leaderboard;
+    try {
+        const char getLeaderboardSql[] =
+            "SELECT players.name, scoreId, mode, grade, startLevel, level, time, date FROM ("
+            "    SELECT *, row_number() OVER ("
+            "        PARTITION BY playerId ORDER BY grade DESC, level DESC, time, scoreId) AS rank "
+            "    FROM scores "
+            "    WHERE mode = :mode) "
+            "JOIN players USING (playerId) "
+            "WHERE rank = 1 "
+            "ORDER BY grade DESC, level DESC, time, date "
+            "LIMIT :limit;";
+
+        check(sqlite3_prepare_v2(records->db, getLeaderboardSql, -1, &sql, NULL) == SQLITE_OK, "Could not prepare sql statement: %s", sqlite3_errmsg(records->db));
+
+        check_bind(records->db, sqlite3_bind_int(sql, sqlite3_bind_parameter_index(sql, ":mode"),  mode));
+        check_bind(records->db, sqlite3_bind_int(sql, sqlite3_bind_parameter_index(sql, ":limit"), limit));
+
+        int ret;
+        while ((ret = sqlite3_step(sql)) == SQLITE_ROW)
+        {
+            const unsigned char *name = sqlite3_column_text(sql, 0);
+            leaderboard.push_back({ name ? reinterpret_cast<const char *>(name) : "", read_reference_descriptor(sql, 1) });
+        }
+        check(ret == SQLITE_DONE, "Could not get leaderboard: %s", sqlite3_errmsg(records->db));
+    }
+    catch (const std::logic_error& error) {
+    }
+    sqlite3_finalize(sql);
+
+    return leaderboard;
+}
+
+static const int benchmark_modes[] = { MODE_PENTOMINO, MODE_G2_DEATH, MODE_G3_TERROR, MODE_G1_MASTER, MODE_G1_20G, MODE_G2_MASTER };
+static const unsigned benchmark_frames = 3600;
+static const int benchmark_page_length = 19;
+static const int benchmark_rivals = 8;
+
+// a minute of made-up inputs, held for a few frames at a time like real ones, with varied results
+static void make_benchmark_replay(unsigned long n, struct replay *out_replay)
+{
+    uint32_t state = uint32_t(n) * 2654435761u + 1u;
+    auto next = [&state]() {
+        state = state * 1103515245u + 12345u;
+        return state >> 16;
+    };
+
+    out_replay->mode = benchmark_modes[n % (sizeof(benchmark_modes) / sizeof(benchmark_modes[0]))];
+    out_replay->mode_flags = 0;
+    out_replay->seed = long(next());
+    out_replay->grade = int(next() % 37);
+    out_replay->starting_level = 0;
+    out_replay->ending_level = int(next() % 1000);
+    out_replay->time = 60 * 60 * 3 + next() % (60 * 60 * 5);
+    out_replay->date = 0;
+    out_replay->index = 0;
+
+    packed_input input = { 0 };
+    for(unsigned i = 0; i < benchmark_frames; i++)
+    {
+        if(next() % 8 == 0)
+            input.data = uint8_t(next() & 0x7f);
+        out_replay->pinputs.push_back(input);
+    }
+}
+
+// everything but the score ID and date, which differ between the two players' copies
+static bool same_results(const Shiro::ReplayDescriptor &a, const Shiro::ReplayDescriptor &b)
+{
+    return a.mode == b.mode && a.grade == b.grade && a.startingLevel == b.startingLevel &&
+           a.endingLevel == b.endingLevel && a.time == b.time;
+}
+
+static bool same_pages(const std::vector<Shiro::ReplayDescriptor> &a, const std::vector<Shiro::ReplayDescriptor> &b)
+{
+    if(a.size() != b.size())
+        return false;
+    for(std::size_t i = 0; i < a.size(); i++)
+    {
+        if(!same_results(a[i], b[i]))
+            return false;
+    }
+    return true;
+}
+
+static bool same_bests(const std::vector<Shiro::ReplayDescriptor> &a, const std::vector<Shiro::ReplayDescriptor> &b)
+{
+    if(!same_pages(a, b))
+        return false;
+    for(std::size_t i = 0; i < a.size(); i++)
+    {
+        if(a[i].scoreId != b[i].scoreId)
+            return false;
+    }
+    return true;
+}
+
+// the two benchmark players' bests tie, so they can be listed either way round; only the names as a whole are compared
+static bool same_leaderboards(const std::vector<Shiro::LeaderboardEntry> &a, const std::vector<Shiro::LeaderboardEntry> &b)
+{
+    if(a.size() != b.size())
+        return false;
+    std::vector<std::string> a_names;
+    std::vector<std::string> b_names;
+    for(std::size_t i = 0; i < a.size(); i++)
+    {
+        if(!same_results(a[i].score, b[i].score))
+            return false;
+        a_names.push_back(a[i].playerName);
+        b_names.push_back(b[i].playerName);
+    }
+    std::sort(a_names.begin(), a_names.end());
+    std::sort(b_names.begin(), b_names.end());
+    return a_names == b_names;
+}
+
+static bool same_replays(const struct replay &a, const struct replay &b)
+{
+    if(a.mode != b.mode || a.mode_flags != b.mode_flags || a.seed != b.seed || a.grade != b.grade ||
+       a.time != b.time || a.starting_level != b.starting_level || a.ending_level != b.ending_level ||
+       a.pinputs.size() != b.pinputs.size())
+        return false;
+    for(std::size_t i = 0; i < a.pinputs.size(); i++)
+    {
+        if(a.pinputs[i].data != b.pinputs[i].data)
+            return false;
+    }
+    return true;
+}
+
+int record_list_benchmark(int argc, const char *const args[])
+{
+    unsigned long scores = 1000;
+    unsigned long queries = 1000;
+    if(argc >= 1)
+        scores = std::strtoul(args[0], nullptr, 10);
+    if(argc >= 2)
+        queries = std::strtoul(args[1], nullptr, 10);
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "shiromino-records-benchmark.sqlite";
+    std::error_code error;
+    std::filesystem::remove(path, error);
+
+    Shiro::RecordList records;
+    scoredb_init(&records, path.string().c_str());
+
+    // the statements are what's being measured, not how fast the disk syncs
+    sqlite3_exec(records.db, "PRAGMA synchronous = OFF;", NULL, NULL, NULL);
+
+    // both implementations add the same scores, each for its own player, so their queries should get the same results
+    Shiro::Player reference_player;
+    Shiro::Player current_player;
+    scoredb_create_player(&records, &reference_player, "benchmark-before");
+    scoredb_create_player(&records, &current_player, "benchmark-now");
+
+    auto nanoseconds = [](std::chrono::steady_clock::duration duration) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    };
+    auto report = [&nanoseconds](const char *name, unsigned long calls,
+                                 std::chrono::steady_clock::duration reference_time, std::chrono::steady_clock::duration current_time) {
+        std::cout << name << ": " << calls << " calls, "
+                  << (calls > 0 ? nanoseconds(reference_time) / 1000.0 / calls : 0.0) << " us/call before, "
+                  << (calls > 0 ? nanoseconds(current_time) / 1000.0 / calls : 0.0) << " us/call now" << std::endl;
+    };
+
+    unsigned long mismatches = 0;
+    std::chrono::steady_clock::duration reference_time{};
+    std::chrono::steady_clock::duration current_time{};
+
+    // both log every score they add
+    std::streambuf *log = std::cerr.rdbuf(nullptr);
+    for(unsigned long i = 0; i < scores; i++)
+    {
+        struct replay r {};
+        make_benchmark_replay(i, &r);
+
+        auto start = std::chrono::steady_clock::now();
+        reference_scoredb_add(&records, &reference_player, &r);
+        reference_time += std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        scoredb_add(&records, &current_player, &r, {});
+        current_time += std::chrono::steady_clock::now() - start;
+    }
+    std::cerr.rdbuf(log);
+    report("add score", scores, reference_time, current_time);
+
+    reference_time = current_time = {};
+    for(unsigned long i = 0; i < queries; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        const int expected = reference_scoredb_get_replay_count(&records, &reference_player);
+        reference_time += std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        const int count = scoredb_get_replay_count(&records, &current_player);
+        current_time += std::chrono::steady_clock::now() - start;
+
+        if(count != expected || count != int(scores))
+        {
+            std::cerr << "replay count " << i << ": expected " << expected << ", got " << count << std::endl;
+            mismatches++;
+        }
+    }
+    report("replay count", queries, reference_time, current_time);
+
+    // the replay menu's first page, then the page after it
+    reference_time = current_time = {};
+    for(unsigned long i = 0; i < queries; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Shiro::ReplayDescriptor> expected = reference_scoredb_get_replay_page(&records, &reference_player, nullptr, benchmark_page_length);
+        std::vector<Shiro::ReplayDescriptor> expected_next;
+        if(!expected.empty())
+            expected_next = reference_scoredb_get_replay_page(&records, &reference_player, &expected.back(), benchmark_page_length);
+        reference_time += std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        std::vector<Shiro::ReplayDescriptor> page = scoredb_get_replay_page(&records, &current_player, nullptr, benchmark_page_length);
+        std::vector<Shiro::ReplayDescriptor> next_page;
+        if(!page.empty())
+            next_page = scoredb_get_replay_page(&records, &current_player, &page.back(), benchmark_page_length);
+        current_time += std::chrono::steady_clock::now() - start;
+
+        if(!same_pages(page, expected) || !same_pages(next_page, expected_next))
+        {
+            std::cerr << "replay pages " << i << " differ" << std::endl;
+            mismatches++;
+        }
+    }
+    report("replay page", queries * 2, reference_time, current_time);
+
+    // a page three quarters of the way down the list, where a key that can't be seeked on would scan everything
+    // before it in the key's mode
+    reference_time = current_time = {};
+    const int deep_position = int(scores - scores / 4);
+    const std::vector<Shiro::ReplayDescriptor> reference_head = reference_scoredb_get_replay_page(&records, &reference_player, nullptr, deep_position);
+    const std::vector<Shiro::ReplayDescriptor> current_head = scoredb_get_replay_page(&records, &current_player, nullptr, deep_position);
+    for(unsigned long i = 0; i < queries && !reference_head.empty() && !current_head.empty(); i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Shiro::ReplayDescriptor> expected = reference_scoredb_get_replay_page(&records, &reference_player, &reference_head.back(), benchmark_page_length);
+        reference_time += std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        std::vector<Shiro::ReplayDescriptor> page = scoredb_get_replay_page(&records, &current_player, &current_head.back(), benchmark_page_length);
+        current_time += std::chrono::steady_clock::now() - start;
+
+        if(!same_pages(page, expected))
+        {
+            std::cerr << "deep replay page " << i << " differs" << std::endl;
+            mismatches++;
+        }
+    }
+    report("deep replay page", reference_head.empty() ? 0 : queries, reference_time, current_time);
+
+    // every score in the database, in turn, read by both
+    reference_time = current_time = {};
+    const unsigned long stored = scores * 2;
+    for(unsigned long i = 0; i < queries && stored > 0; i++)
+    {
+        const int score_id = int(1 + i % stored);
+        struct replay expected {};
+        struct replay r {};
+
+        auto start = std::chrono::steady_clock::now();
+        reference_scoredb_get_full_replay(&records, &expected, score_id);
+        reference_time += std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        scoredb_get_full_replay(&records, &r, score_id);
+        current_time += std::chrono::steady_clock::now() - start;
+
+        if(!same_replays(r, expected) || r.pinputs.size() != benchmark_frames)
+        {
+            std::cerr << "replay " << score_id << " differs" << std::endl;
+            mismatches++;
+        }
+    }
+    report("full replay", stored > 0 ? queries : 0, reference_time, current_time);
+
+    // some rivals, so leaderboards have more than the two benchmark players on them; not timed
+    log = std::cerr.rdbuf(nullptr);
+    for(int i = 0; i < benchmark_rivals; i++)
+    {
+        Shiro::Player rival;
+        scoredb_create_player(&records, &rival, ("benchmark-rival-" + std::to_string(i)).c_str());
+        for(unsigned long j = 0; j < scores / benchmark_rivals; j++)
+        {
+            struct replay r {};
+            make_benchmark_replay(scores + i * scores + j, &r);
+            scoredb_add(&records, &rival, &r, {});
+        }
+    }
+    std::cerr.rdbuf(log);
+
+    // the records menu: a player's bests, then a mode's leaderboard
+    reference_time = current_time = {};
+    for(unsigned long i = 0; i < queries; i++)
+    {
+        const int mode = benchmark_modes[i % (sizeof(benchmark_modes) / sizeof(benchmark_modes[0]))];
+
+        auto start = std::chrono::steady_clock::now();
+        const std::vector<Shiro::ReplayDescriptor> expected_bests = reference_scoredb_get_personal_bests(&records, &current_player);
+        const std::vector<Shiro::LeaderboardEntry> expected_board = reference_scoredb_get_leaderboard(&records, mode, benchmark_page_length);
+        reference_time += std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        const std::vector<Shiro::ReplayDescriptor> bests = scoredb_get_personal_bests(&records, &current_player);
+        const std::vector<Shiro::LeaderboardEntry> board = scoredb_get_leaderboard(&records, mode, benchmark_page_length);
+        current_time += std::chrono::steady_clock::now() - start;
+
+        if(!same_bests(bests, expected_bests) || !same_leaderboards(board, expected_board) ||
+           (scores > 0 && board.empty()))
+        {
+            std::cerr << "personal bests or leaderboard " << i << " differ" << std::endl;
+            mismatches++;
+        }
+    }
+    report("bests and leaderboard", queries * 2, reference_time, current_time);
+
+    scoredb_terminate(&records);
+    std::filesystem::remove(path, error);
+
+    std::cout << (mismatches == 0 ? "identical results" : "RESULTS DIFFER") << std::endl;
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+/**
+ * `--benchmark-records [scores] [queries]`: in a scratch database, adds
+ * `scores` scores, then runs `queries` rounds of the replay list queries,
+ * once with the scoredb_* functions and once with the original versions
+ * kept in RecordListBenchmark.cc, which prepared every statement on every
+ * call. Personal bests and leaderboards are checked the same way against
+ * brute-force queries over every score. Checks that both got the same
+ * results and prints the latency of each. `args` are the arguments
+ * following the flag. Returns an exit code; nonzero if any result
+ * differed.
+ */
+int record_list_benchmark(int argc, const char *const args[]);
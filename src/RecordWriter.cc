@@ -0,0 +1,129 @@
+#include "RecordWriter.h"
+#include <algorithm>
+#include <iostream>
+#include <sqlite3.h>
+#include <utility>
+
+Shiro::RecordWriter::RecordWriter() :
+    numQueued(0u),
+    numCommitted(0u),
+    stopping(false) {}
+
+Shiro::RecordWriter::~RecordWriter() {
+    stop();
+}
+
+void Shiro::RecordWriter::start(const std::string& filename) {
+    if (thread.joinable()) {
+        return;
+    }
+    stopping = false;
+    thread = std::thread(&RecordWriter::run, this, filename);
+}
+
+void Shiro::RecordWriter::add(const Player& player, struct replay&& r, std::vector<SectionSplit>&& splits) {
+    queue({ player, std::make_unique<struct replay>(std::move(r)), std::move(splits) });
+}
+
+void Shiro::RecordWriter::updatePlayer(const Player& player) {
+    queue({ player, nullptr, {} });
+}
+
+void Shiro::RecordWriter::queue(Write&& write) {
+    if (!thread.joinable()) {
+        std::cerr << "Record writer isn't running; dropped a write" << std::endl;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (write.replay) {
+            std::map<int, SectionSplit>& bests = queuedBestSplits[{ write.player.playerId, write.replay->mode }];
+            for (const SectionSplit& split : write.splits) {
+                const auto best = bests.find(split.section);
+                if (best == bests.end() || split.time < best->second.time) {
+                    bests[split.section] = split;
+                }
+            }
+        }
+        writes.push_back(std::move(write));
+        numQueued++;
+    }
+    queued.notify_one();
+}
+
+void Shiro::RecordWriter::foldQueuedBestSplits(const Player& player, int mode, std::vector<SectionSplit>& splits) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto queuedBests = queuedBestSplits.find({ player.playerId, mode });
+    if (queuedBests == queuedBestSplits.end()) {
+        return;
+    }
+
+    for (const auto& [section, queuedBest] : queuedBests->second) {
+        const auto split = std::find_if(splits.begin(), splits.end(), [section = section](const SectionSplit& split) {
+            return split.section == section;
+        });
+        if (split == splits.end()) {
+            splits.push_back(queuedBest);
+        }
+        else if (queuedBest.time < split->time) {
+            *split = queuedBest;
+        }
+    }
+}
+
+void Shiro::RecordWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    const std::uint64_t target = numQueued;
+    committed.wait(lock, [this, target] { return numCommitted >= target; });
+}
+
+void Shiro::RecordWriter::stop() {
+    if (!thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queued.notify_one();
+    thread.join();
+}
+
+void Shiro::RecordWriter::run(std::string filename) {
+    RecordList records;
+    scoredb_init(&records, filename.c_str());
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        queued.wait(lock, [this] { return stopping || !writes.empty(); });
+        if (writes.empty()) {
+            break;
+        }
+
+        std::deque<Write> batch;
+        batch.swap(writes);
+        lock.unlock();
+
+        // one commit for the whole batch, rather than one per write
+        const bool transaction = sqlite3_exec(records.db, "BEGIN;", NULL, NULL, NULL) == SQLITE_OK;
+        for (Write& write : batch) {
+            if (write.replay) {
+                scoredb_add(&records, &write.player, write.replay.get(), write.splits);
+            }
+            else {
+                scoredb_update_player(&records, &write.player);
+            }
+        }
+        if (transaction && sqlite3_exec(records.db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+            std::cerr << "Could not commit record list writes: " << sqlite3_errmsg(records.db) << std::endl;
+            sqlite3_exec(records.db, "ROLLBACK;", NULL, NULL, NULL);
+        }
+
+        lock.lock();
+        numCommitted += batch.size();
+        committed.notify_all();
+    }
+    lock.unlock();
+
+    scoredb_terminate(&records);
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "Player.h"
+#include "RecordList.h"
+#include "replay.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Shiro {
+    /**
+     * Writes scores and player updates to a record list on a thread of its
+     * own, so a game ending never waits on the database. Writes are queued
+     * and run in order; whatever has queued up while the thread was busy is
+     * written in a single transaction.
+     *
+     * The thread has its own connection to the database, and record lists
+     * are in WAL mode, so reads on the game's connection don't wait for
+     * writes either. They only see writes that have been committed, though;
+     * flush() first if a read has to see everything queued so far, or, for
+     * best splits, fold in the queued ones with foldQueuedBestSplits().
+     */
+    class RecordWriter {
+    public:
+        RecordWriter();
+        ~RecordWriter();
+
+        RecordWriter(const RecordWriter&) = delete;
+        RecordWriter& operator=(const RecordWriter&) = delete;
+
+        /**
+         * Starts the thread, which opens the record list `filename`. Does
+         * nothing if it's already running.
+         */
+        void start(const std::string& filename);
+
+        /**
+         * Queues scoredb_add for the replay and the game's splits, taking
+         * the replay's inputs.
+         */
+        void add(const Player& player, struct replay&& r, std::vector<SectionSplit>&& splits);
+
+        /**
+         * Queues scoredb_update_player with the player's counts as they
+         * are now.
+         */
+        void updatePlayer(const Player& player);
+
+        /**
+         * Lowers each of `splits`, best splits read from the database, to the
+         * fastest split of its section queued for the player in `mode`, and
+         * adds sections only queued games have. Doesn't wait for the queue.
+         */
+        void foldQueuedBestSplits(const Player& player, int mode, std::vector<SectionSplit>& splits);
+
+        /**
+         * Waits until everything queued so far has been committed.
+         */
+        void flush();
+
+        /**
+         * Writes everything still queued, then ends the thread and closes
+         * its connection. Safe to call more than once.
+         */
+        void stop();
+
+    private:
+        struct Write {
+            Player player;
+            std::unique_ptr<struct replay> replay; // null for a player update
+            std::vector<SectionSplit> splits;
+        };
+
+        void queue(Write&& write);
+        void run(std::string filename);
+
+        std::mutex mutex;
+        std::condition_variable queued;
+        std::condition_variable committed;
+        std::deque<Write> writes;
+        // fastest split of each section ever queued, by player ID and mode, then section
+        std::map<std::pair<int, int>, std::map<int, SectionSplit>> queuedBestSplits;
+        // writes ever queued and ever committed; everything queued by the time numQueued was n is written once numCommitted reaches n
+        std::uint64_t numQueued;
+        std::uint64_t numCommitted;
+        bool stopping;
+        std::thread thread;
+    };
+}
@@ -0,0 +1,116 @@
+#include "ReplayKeyframes.h"
+#include "CoreState.h"
+#include "GameSnapshot.h"
+#include "Headless.h"
+#include "QRS0.h"
+#include "game_qs.h"
+#include "replay.h"
+#include <algorithm>
+#include <climits>
+#include <utility>
+
+Shiro::ReplayKeyframes::ReplayKeyframes() {}
+
+Shiro::ReplayKeyframes::~ReplayKeyframes() {}
+
+void Shiro::ReplayKeyframes::capture(CoreState& cs, game_t& g) {
+    qrsdata *q = static_cast<qrsdata *>(g.data);
+    const unsigned frame = static_cast<unsigned>(q->playback_index);
+
+    while (sectionStarts.size() <= static_cast<std::size_t>(q->section)) {
+        sectionStarts.push_back(frame);
+    }
+
+    if (frame != keyframes.size() * interval) {
+        return;
+    }
+
+    std::vector<std::uint8_t> keyframe;
+    GameSnapshot::save(cs, g, keyframe);
+    keyframes.push_back(std::move(keyframe));
+}
+
+void Shiro::ReplayKeyframes::restore(CoreState& cs, game_t& g, const std::vector<std::uint8_t>& keyframe) {
+    qrsdata *q = static_cast<qrsdata *>(g.data);
+
+    // the seek resyncs the music once it's done, so restoring shouldn't switch tracks
+    PresentationSink *sink = g.sink;
+    const int music = q->music;
+    g.sink = nullptr;
+    GameSnapshot::restore(cs, g, keyframe.data(), keyframe.size());
+    g.sink = sink;
+    q->music = music;
+
+    // captured before the frame's input was read, when prev_keys held the last input played back
+    cs.keys = cs.prev_keys;
+}
+
+bool Shiro::ReplayKeyframes::simulateTo(CoreState& cs, game_t& g, unsigned frame, int section) {
+    qrsdata *q = static_cast<qrsdata *>(g.data);
+    const struct packed_input none = { 0 };
+    bool running = true;
+
+    // nothing simulated while seeking should be drawn or heard, and the
+    // player's own keys have to survive the simulated frames
+    PresentationSink *sink = g.sink;
+    const KeyFlags keysRaw = cs.keys_raw;
+    const KeyFlags prevKeysRaw = cs.prev_keys_raw;
+    const int music = q->music;
+    g.sink = nullptr;
+
+    while (q->playback && static_cast<unsigned>(q->playback_index) < frame && q->section < section) {
+        if (!headless_game_frame(&cs, &g, none)) {
+            running = false;
+            break;
+        }
+    }
+
+    g.sink = sink;
+    cs.keys_raw = keysRaw;
+    cs.prev_keys_raw = prevKeysRaw;
+    cs.prev_keys = cs.keys;
+    q->music = music;
+    qs_sync_music(&g);
+
+    return running && q->playback;
+}
+
+bool Shiro::ReplayKeyframes::seek(CoreState& cs, game_t& g, unsigned frame) {
+    qrsdata *q = static_cast<qrsdata *>(g.data);
+
+    if (!q->playback || keyframes.empty()) {
+        return false;
+    }
+
+    // the frame that ends playback is left for the normal game loop to run
+    frame = std::min(frame, static_cast<unsigned>(q->replay->pinputs.size()));
+
+    const std::size_t index = std::min<std::size_t>(frame / interval, keyframes.size() - 1);
+    const unsigned current = static_cast<unsigned>(q->playback_index);
+
+    // going forward within reach of the current position doesn't need a keyframe
+    if (frame < current || current < index * interval) {
+        restore(cs, g, keyframes[index]);
+    }
+
+    return simulateTo(cs, g, frame, INT_MAX);
+}
+
+bool Shiro::ReplayKeyframes::seekSection(CoreState& cs, game_t& g, int section) {
+    qrsdata *q = static_cast<qrsdata *>(g.data);
+
+    if (section < 0 || keyframes.empty()) {
+        return false;
+    }
+    if (static_cast<std::size_t>(section) < sectionStarts.size()) {
+        return seek(cs, g, sectionStarts[section]);
+    }
+
+    // not played yet: continue from the furthest point reached until the section starts
+    const unsigned furthest = static_cast<unsigned>((keyframes.size() - 1) * interval);
+    if (!seek(cs, g, std::max(static_cast<unsigned>(q->playback_index), furthest))) {
+        return false;
+    }
+
+    return simulateTo(cs, g, static_cast<unsigned>(q->replay->pinputs.size()), section) && q->section >= section;
+}
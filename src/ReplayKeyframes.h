@@ -0,0 +1,59 @@
+#pragma once
+#include "Game.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct CoreState;
+
+namespace Shiro {
+    /**
+     * Periodic GameSnapshots of a QRS game taken while a replay plays back, so
+     * the viewer can jump to any frame without re-simulating from the start.
+     * Keyframes are captured every `interval` frames of playback, including
+     * frames simulated while seeking forward, so a seek restores the nearest
+     * earlier keyframe and simulates at most `interval - 1` frames.
+     * Simulated frames run without a PresentationSink, so nothing is drawn or
+     * played while seeking.
+     */
+    class ReplayKeyframes {
+    public:
+        static constexpr unsigned interval = 300u; // 5 seconds at 60 fps
+
+        ReplayKeyframes();
+        ~ReplayKeyframes();
+
+        ReplayKeyframes(const ReplayKeyframes&) = delete;
+        ReplayKeyframes& operator=(const ReplayKeyframes&) = delete;
+
+        /**
+         * Called before each playback frame consumes its input; stores a
+         * keyframe if this frame is on the interval and doesn't have one yet,
+         * and notes the frame each section starts on.
+         */
+        void capture(CoreState& cs, game_t& g);
+
+        /**
+         * Moves playback so the next input consumed is `frame`'s. Frames past
+         * the last captured keyframe are simulated, capturing new keyframes
+         * on the way. Returns false if the game ended while simulating.
+         */
+        bool seek(CoreState& cs, game_t& g, unsigned frame);
+
+        /**
+         * Seeks to the first frame of `section`, simulating forward until the
+         * game reaches it if it hasn't been played yet. Returns false if the
+         * replay ends before that section.
+         */
+        bool seekSection(CoreState& cs, game_t& g, int section);
+
+    private:
+        void restore(CoreState& cs, game_t& g, const std::vector<std::uint8_t>& keyframe);
+        bool simulateTo(CoreState& cs, game_t& g, unsigned frame, int section);
+
+        // keyframes[i] is taken at playback frame i * interval
+        std::vector<std::vector<std::uint8_t>> keyframes;
+        // the playback frame each section was first reached on
+        std::vector<unsigned> sectionStarts;
+    };
+}
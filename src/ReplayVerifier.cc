@@ -0,0 +1,157 @@
+#include "ReplayVerifier.h"
+#include "CoreState.h"
+#include "Headless.h"
+#include "RecordList.h"
+#include "Settings.h"
+#include "replay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// frames simulated before playback starts (READY/GO) and after its last input, with room to spare
+#define VERIFY_EXTRA_FRAMES 600
+
+namespace {
+    struct VerifyResult {
+        int score_id;
+        int mode;
+        bool readable;
+        int stored_grade;
+        int stored_level;
+        uint64_t stored_time;
+        Shiro::HeadlessResult simulated;
+    };
+
+    // everything the workers share; fetching is serialized so each score is handed out once
+    struct VerifyQueue {
+        Shiro::RecordList *records;
+        std::mutex mutex;
+        int last_score_id;
+    };
+}
+
+static void verify_worker(VerifyQueue &queue, Shiro::Settings &settings, std::vector<VerifyResult> &results)
+{
+    CoreState cs(settings);
+    Shiro::ReplayDescriptor stored;
+    struct replay r;
+    std::vector<uint8_t> data;
+
+    for(;;)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if(!scoredb_get_next_raw_replay(queue.records, queue.last_score_id, &stored, &data))
+                break;
+
+            queue.last_score_id = stored.scoreId;
+        }
+
+        VerifyResult result = {};
+        result.score_id = stored.scoreId;
+        result.mode = stored.mode;
+        result.stored_grade = stored.grade;
+        result.stored_level = stored.endingLevel;
+        result.stored_time = stored.time;
+        result.readable = read_replay_from_memory(&r, data.data(), data.size()) &&
+            headless_simulate_replay(&cs, &r, &result.simulated, r.pinputs.size() + VERIFY_EXTRA_FRAMES) == 0;
+
+        results.push_back(result);
+    }
+}
+
+int replay_verification(int argc, const char *const args[])
+{
+    const char *filename = argc >= 1 ? args[0] : "shiromino.sqlite";
+    unsigned int num_threads = argc >= 2 ? unsigned(std::strtoul(args[1], nullptr, 10)) : std::thread::hardware_concurrency();
+
+    if(num_threads == 0)
+        num_threads = 1;
+
+    // scoredb_init would create an empty database rather than fail
+    if(!std::filesystem::exists(filename))
+    {
+        std::cerr << "Couldn't find scores database `" << filename << "`" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Shiro::RecordList records;
+    scoredb_init(&records, filename);
+
+    VerifyQueue queue;
+    queue.records = &records;
+    queue.last_score_id = -1;
+
+    Shiro::Settings settings;
+    std::vector<std::vector<VerifyResult>> results(num_threads);
+    std::vector<std::thread> workers;
+
+    std::cerr << "Using " << num_threads << " threads" << std::endl;
+    const auto start = std::chrono::steady_clock::now();
+
+    for(unsigned int w = 0; w < num_threads; w++)
+        workers.emplace_back(verify_worker, std::ref(queue), std::ref(settings), std::ref(results[w]));
+
+    std::vector<VerifyResult> all;
+    for(unsigned int w = 0; w < num_threads; w++)
+    {
+        workers[w].join();
+        all.insert(all.end(), results[w].begin(), results[w].end());
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    scoredb_terminate(&records);
+
+    std::sort(all.begin(), all.end(), [](const VerifyResult &a, const VerifyResult &b) { return a.score_id < b.score_id; });
+
+    unsigned long mismatches = 0;
+    unsigned long unreadable = 0;
+    uint64_t frames = 0;
+
+    for(const VerifyResult &result : all)
+    {
+        if(!result.readable)
+        {
+            std::cout << "score " << result.score_id << ": replay couldn't be read" << std::endl;
+            unreadable++;
+            continue;
+        }
+
+        frames += result.simulated.frames;
+
+        const bool grade_ok = result.simulated.grade == result.stored_grade;
+        const bool level_ok = result.simulated.ending_level == result.stored_level;
+        const bool time_ok = result.simulated.time == result.stored_time;
+
+        if(grade_ok && level_ok && time_ok)
+            continue;
+
+        mismatches++;
+        std::cout << "score " << result.score_id << " (mode " << result.mode << "):";
+        if(!grade_ok)
+            std::cout << " grade " << result.stored_grade << " stored, " << result.simulated.grade << " simulated;";
+        if(!level_ok)
+            std::cout << " level " << result.stored_level << " stored, " << result.simulated.ending_level << " simulated;";
+        if(!time_ok)
+            std::cout << " time " << result.stored_time << " stored, " << result.simulated.time << " simulated;";
+        std::cout << std::endl;
+    }
+
+    std::cout << all.size() << " replays verified: " << all.size() - mismatches - unreadable << " match, "
+              << mismatches << " mismatched, " << unreadable << " unreadable" << std::endl;
+    std::cout << std::fixed << std::setprecision(3)
+              << frames << " frames in " << seconds << " s: "
+              << std::setprecision(1) << (seconds > 0.0 ? double(all.size()) / seconds : 0.0) << " replays/s, "
+              << std::setprecision(0) << (seconds > 0.0 ? double(frames) / seconds : 0.0) << " frames/s" << std::endl;
+
+    return mismatches == 0 && unreadable == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * `--verify-replays [database] [threads]`: re-simulates every replay stored
+ * in the scores database (shiromino.sqlite by default) with the headless QRS
+ * engine, spread over a pool of threads, and reports every score whose
+ * stored grade, level or time doesn't match what its replay produces, along
+ * with replays/sec and frames/sec. `args` are the arguments following the
+ * flag. Returns an exit code; failure if any replay mismatched or couldn't
+ * be read.
+ */
+int replay_verification(int argc, const char *const args[]);
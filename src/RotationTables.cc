@@ -1,7 +1,7 @@
 #include "RotationTables.h"
 #define O true
 #define _ false
-const std::array<std::array<std::array<std::array<bool, 5>, 5>, 4>, 18> Shiro::PentoRotationTables =
+constexpr std::array<std::array<std::array<std::array<bool, 5>, 5>, 4>, 18> Shiro::PentoRotationTables =
 {
     std::array<std::array<std::array<bool, 5>, 5>, 4>
     { // I
@@ -707,7 +707,7 @@ const std::array<std::array<std::array<std::array<bool, 5>, 5>, 4>, 18> Shiro::P
     }
 };
 
-const std::array<std::array<std::array<std::array<bool, 4>, 4>, 4>, 7> Shiro::TetroRotationTables =
+constexpr std::array<std::array<std::array<std::array<bool, 4>, 4>, 4>, 7> Shiro::TetroRotationTables =
 {
     std::array<std::array<std::array<bool, 4>, 4>, 4>
     { // I4
@@ -956,4 +956,38 @@ const std::array<std::array<std::array<std::array<bool, 4>, 4>, 4>, 7> Shiro::Te
     }
 };
 #undef _
-#undef O
\ No newline at end of file
+#undef O
+
+namespace {
+    template<std::size_t N>
+    constexpr Shiro::RotationMask makeRotationMask(const std::array<std::array<bool, N>, N>& table) {
+        Shiro::RotationMask mask {};
+        mask.width = N;
+        mask.height = N;
+        for (std::size_t y = 0; y < N; y++) {
+            for (std::size_t x = 0; x < N; x++) {
+                if (table[y][x]) {
+                    mask.rows[y] |= static_cast<std::uint8_t>(1u << x);
+                }
+            }
+        }
+        return mask;
+    }
+
+    constexpr std::array<std::array<Shiro::RotationMask, 4>, 25> makePieceRotationMasks() {
+        std::array<std::array<Shiro::RotationMask, 4>, 25> masks {};
+        for (std::size_t i = 0; i < 18; i++) {
+            for (std::size_t r = 0; r < 4; r++) {
+                masks[i][r] = makeRotationMask(Shiro::PentoRotationTables[i][r]);
+            }
+        }
+        for (std::size_t i = 0; i < 7; i++) {
+            for (std::size_t r = 0; r < 4; r++) {
+                masks[18 + i][r] = makeRotationMask(Shiro::TetroRotationTables[i][r]);
+            }
+        }
+        return masks;
+    }
+}
+
+constexpr std::array<std::array<Shiro::RotationMask, 4>, 25> Shiro::PieceRotationMasks = makePieceRotationMasks();
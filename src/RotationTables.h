@@ -1,8 +1,26 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
 
 namespace Shiro {
     extern const std::array<std::array<std::array<std::array<bool, 5>, 5>, 4>, 18> PentoRotationTables;
     extern const std::array<std::array<std::array<std::array<bool, 4>, 4>, 4>, 7> TetroRotationTables;
+
+    /**
+     * Precomputed bit masks of one rotation of a piece. Bit x of rows[y] is
+     * set if cell (x, y) of the rotation is filled.
+     */
+    struct RotationMask {
+        static constexpr std::size_t maxSize = 5u;
+
+        std::uint8_t width;
+        std::uint8_t height;
+        std::array<std::uint8_t, maxSize> rows;
+    };
+
+    // Built at compile time from the tables above, in QRS piece pool order:
+    // the 18 pentominoes, then the 7 tetrominoes.
+    extern const std::array<std::array<RotationMask, 4>, 25> PieceRotationMasks;
 }
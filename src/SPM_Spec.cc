@@ -6,24 +6,7 @@ bool SPM_Spec::checkCollision(Shiro::Grid* field, ActivatedPolyomino& mino) {
     return checkCollision(field, mino, pos);
 }
 bool SPM_Spec::checkCollision(Shiro::Grid *field, ActivatedPolyomino& mino, std::pair<int, int>& pos) {
-    Shiro::Grid d = mino.currentRotationTable();
-
-    int d_x = 0;
-    int d_y = 0;
-
-    int f_x = 0;
-    int f_y = 0;
-
-    for (d_y = 0, f_y = mino.position.y; d_y < int(d.getHeight()); d_y++, f_y++) {
-        for (d_x = 0, f_x = mino.position.x; d_x < int(d.getWidth()); d_x++, f_x++) {
-            if (d.getCell(d_x, d_y) && field->getCell(f_x, f_y)) {
-                pos = std::pair<int, int>(d_x, d_y);
-                return true;
-            }
-        }
-    }
-
-    return false;
+    return field->collides(mino.currentRotationTable(), mino.position.x, mino.position.y, pos);
 }
 
 bool SPM_Spec::isGrounded(Shiro::Grid *field, ActivatedPolyomino& mino)
@@ -148,9 +131,9 @@ void SPM_Spec::dropField(Shiro::Grid *field)
         }
 
         if(i - n >= 0)
-        // if the row to copy downward is within bounds
+        // if the row to move downward is within bounds
         {
-            field->copyRow(i - n, i);
+            field->swapRows(i - n, i);
         }
         else
         // make an empty row
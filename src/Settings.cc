@@ -25,6 +25,7 @@ Shiro::Settings::Settings() :
     sfxVolume(100),
     musicVolume(90),
     samplingRate(48000),
+    practiceRewindMemory(4096),
     configurationPath(""),
     basePath(""),
     playerName("ARK") {}
@@ -141,6 +142,10 @@ void Shiro::Settings::read(std::string filename) {
         this->interpolate = !!interpolate;
     }
 #endif
+    unsigned int practiceRewindMemory;
+    if (ini.get("PRACTICE", "REWIND_MEMORY", practiceRewindMemory)) {
+        this->practiceRewindMemory = std::clamp(practiceRewindMemory, 0u, 1024u * 1024u);
+    }
     std::string playerName;
     if (ini.get("ACCOUNT", "PLAYER_NAME", playerName)) {
         this->playerName = playerName;
@@ -162,6 +167,8 @@ void Shiro::Settings::write() const {
     ini.set("AUDIO", "MUSIC_VOLUME", musicVolume);
     ini.set("AUDIO", "SAMPLING_RATE", samplingRate);
 
+    ini.set("PRACTICE", "REWIND_MEMORY", practiceRewindMemory);
+
     ini.set("SCREEN", "VIDEO_SCALE", videoScale);
     ini.set("SCREEN", "VIDEO_STRETCH", videoStretch);
     ini.set("SCREEN", "FULL_SCREEN", fullscreen);
@@ -184,4 +191,8 @@ void Shiro::Settings::write() const {
 
 static void printHelp(const char* executableName) {
     std::cerr << "Usage: " << executableName << " --configuration-file <configuration file>" << std::endl;
+    std::cerr << "       " << executableName << " --analyze-randomizer <pento|g1|g2|g3> [pieces] [seed] [threads]" << std::endl;
+    std::cerr << "       " << executableName << " --benchmark-randomizer [seeds] [pieces]" << std::endl;
+    std::cerr << "       " << executableName << " --benchmark-records [scores] [queries]" << std::endl;
+    std::cerr << "       " << executableName << " --verify-replays [database] [threads]" << std::endl;
 }
@@ -28,6 +28,7 @@ namespace Shiro {
         int sfxVolume;
         int musicVolume;
         int samplingRate;
+        int practiceRewindMemory; // in KiB
         std::filesystem::path configurationPath;
         std::filesystem::path basePath;
         std::string playerName;
@@ -0,0 +1,118 @@
+#include "UserSequence.h"
+#include "QRS0.h"
+#include "game_qs.h"
+#include <algorithm>
+
+Shiro::UserSequence::UserSequence() :
+    finiteLength(0u),
+    cursor(0u),
+    infinite(false),
+    entered(false) {}
+
+void Shiro::UserSequence::clear() {
+    pieces.clear();
+    runs.clear();
+    finiteLength = 0u;
+    cursor = 0u;
+    infinite = false;
+    entered = false;
+}
+
+bool Shiro::UserSequence::empty() const {
+    return !entered;
+}
+
+void Shiro::UserSequence::append(const std::vector<int>& elements, std::size_t start, std::size_t length, std::size_t count) {
+    if (!length || !count) {
+        return;
+    }
+
+    // consecutive stretches that play once are merged into one run
+    if (count == 1u && !runs.empty() && runs.back().count == 1u) {
+        runs.back().length += length;
+    }
+    else {
+        runs.push_back({ finiteLength, pieces.size(), length, count });
+    }
+
+    for (std::size_t i = start; i < start + length; i++) {
+        pieces.push_back(static_cast<std::uint8_t>(elements[i] & 0b11111));
+    }
+    finiteLength += length * count;
+}
+
+void Shiro::UserSequence::compile(const std::vector<int>& elements) {
+    clear();
+    entered = !elements.empty();
+
+    const std::size_t n = elements.size();
+    std::size_t i = 0u;
+    while (i < n) {
+        if (!(elements[i] & SEQUENCE_REPEAT_START)) {
+            append(elements, i, 1u, 1u);
+            i++;
+            continue;
+        }
+
+        // a group runs to the next piece marked as its end; an unclosed one runs to the end of the sequence
+        std::size_t last = i;
+        while (!(elements[last] & SEQUENCE_REPEAT_END) && last != n - 1u) {
+            last++;
+        }
+        const std::size_t length = last - i + 1u;
+        const std::size_t countIndex = last + 1u;
+
+        if (countIndex < n && elements[countIndex] == SEQUENCE_REPEAT_INF) {
+            // nothing after a group that repeats forever is ever reached
+            runs.push_back({ finiteLength, pieces.size(), length, 1u });
+            for (std::size_t k = i; k <= last; k++) {
+                pieces.push_back(static_cast<std::uint8_t>(elements[k] & 0b11111));
+            }
+            infinite = true;
+            break;
+        }
+
+        // a group without a count plays once
+        std::size_t count = 1u;
+        if (countIndex < n) {
+            count = static_cast<std::size_t>(std::clamp(elements[countIndex], 0, USRSEQ_RPTCOUNT_MAX));
+        }
+        append(elements, i, length, count);
+        i = countIndex + 1u;
+    }
+
+    pieces.shrink_to_fit();
+    runs.shrink_to_fit();
+}
+
+int Shiro::UserSequence::at(std::size_t index) const {
+    if (runs.empty()) {
+        return USRSEQ_ELEM_OOB;
+    }
+
+    if (infinite) {
+        const Run& tail = runs.back();
+        if (index >= tail.first) {
+            return pieces[tail.offset + (index - tail.first) % tail.length];
+        }
+    }
+    else if (index >= finiteLength) {
+        return USRSEQ_ELEM_OOB;
+    }
+
+    // the last run starting at or before index
+    if (index >= runs[cursor].first) {
+        while (cursor + 1u < runs.size() && index >= runs[cursor + 1u].first) {
+            cursor++;
+        }
+    }
+    else {
+        const auto run = std::upper_bound(runs.begin(), runs.end(), index, [](std::size_t i, const Run& r) {
+            return i < r.first;
+        });
+        cursor = static_cast<std::size_t>(run - runs.begin()) - 1u;
+    }
+
+    const Run& run = runs[cursor];
+    return pieces[run.offset + (index - run.first) % run.length];
+}
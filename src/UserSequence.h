@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Shiro {
+    /**
+     * A practice user sequence, compiled once from its parsed form into
+     * runs: a stretch of pieces and how many times it repeats. The sequence
+     * can end with a group that repeats forever. Pieces are dealt in order,
+     * so a lookup starts from the run the last one ended in and steps
+     * forward, which is O(1) amortised however long the expanded sequence
+     * is; looking back falls back to a binary search over the runs.
+     */
+    class UserSequence {
+    public:
+        UserSequence();
+
+        /**
+         * Compiles a parsed sequence, as produced by qs_update_pracdata:
+         * piece IDs, where SEQUENCE_REPEAT_START and SEQUENCE_REPEAT_END
+         * flags mark a group's first and last piece, and the element after a
+         * group is its repeat count or SEQUENCE_REPEAT_INF.
+         */
+        void compile(const std::vector<int>& elements);
+
+        void clear();
+
+        // true when no sequence was entered, even if the one entered expands to nothing
+        bool empty() const;
+
+        /**
+         * The piece at `index` of the expanded sequence, or USRSEQ_ELEM_OOB
+         * past the end of a sequence that doesn't repeat forever.
+         */
+        int at(std::size_t index) const;
+
+    private:
+        struct Run {
+            std::size_t first;  // index in the expanded sequence of the run's first piece
+            std::size_t offset; // where its pieces start in `pieces`
+            std::size_t length;
+            std::size_t count;
+        };
+
+        void append(const std::vector<int>& elements, std::size_t start, std::size_t length, std::size_t count);
+
+        std::vector<std::uint8_t> pieces;
+        std::vector<Run> runs;
+        // the expanded length, not counting a group that repeats forever
+        std::size_t finiteLength;
+        // the run the last lookup found
+        mutable std::size_t cursor;
+        // the last run repeats forever
+        bool infinite;
+        bool entered;
+    };
+}
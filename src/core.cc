@@ -18,6 +18,7 @@
 #include "QRS1.h"
 #include "RefreshRates.h"
 #include "replay.h"
+#include "ReplayKeyframes.h"
 #include "SGUIL/SGUIL.h"
 #include "ShiroPhysoMino.h"
 #include "SPM_Spec.h"
@@ -31,6 +32,7 @@
 #include <ctime>
 #include <filesystem>
 #include <iostream>
+#include <optional>
 #include "SDL.h"
 #include "SDL_image.h"
 #include "SDL_mixer.h"
@@ -45,7 +47,6 @@
 #include "glad/glad.h"
 #endif
 
-#define PENTOMINO_C_REVISION_STRING "rev 1.3"
 #define FRAMEDELAY_ERR 0
 
 #if(defined(_WIN64) || defined(_WIN32)) && !defined(__CYGWIN__) && !defined(__CYGWIN32__) && !defined(__MINGW32__) && \
@@ -156,7 +157,8 @@ CoreState::CoreState(Shiro::Settings& settings) :
     screen(Shiro::Version::DESCRIPTOR, static_cast<unsigned>(settings.videoScale * 640.0f), static_cast<unsigned>(settings.videoScale * 480.0f)),
     settings(settings),
     bg(screen),
-    gfx(screen)
+    gfx(screen),
+    sink(*this)
 {
     fps = Shiro::RefreshRates::menu;
     // keyquit = SDLK_F11;
@@ -199,6 +201,8 @@ CoreState::CoreState(Shiro::Settings& settings) :
     this->settings = settings;
     menu_input_override = false;
     button_emergency_override = false;
+    replay_seek_steps = 0;
+    replay_fast_forward = false;
     p1game = NULL;
     menu = NULL;
 
@@ -471,6 +475,7 @@ bool CoreState::init() {
         static const char scoredb_file[] = "shiromino.sqlite";
         scoredb_init(&records, scoredb_file);
         scoredb_create_player(&records, &player, settings.playerName.c_str());
+        recordWriter.start(scoredb_file);
 
         /*
         static const char archive_file[] = "archive.db";
@@ -556,6 +561,8 @@ void CoreState::run() {
         currentTime = newTime;
         timeAccumulator += renderFrameTime;
 
+        profiler.beginFrame();
+
         unsigned newFrames = 0u;
         for (
 #ifdef DEBUG_FRAME_TIMING
@@ -571,14 +578,21 @@ void CoreState::run() {
             prev_keys_raw = keys_raw;
             prev_keys = keys;
 
-            running = process_events();
+            {
+                Shiro::FrameProfiler::Scope scope(profiler, Shiro::FrameProfiler::Phase::events);
+                running = process_events();
+            }
 
-            handle_replay_input();
+            {
+                Shiro::FrameProfiler::Scope scope(profiler, Shiro::FrameProfiler::Phase::input);
+                handle_replay_seek();
+                handle_replay_input();
 
-            update_input_repeat();
-            update_pressed();
+                update_input_repeat();
+                update_pressed();
 
-            gfx_buttons_input();
+                gfx_buttons_input();
+            }
 
             /*
             SPMgame.input();
@@ -588,25 +602,28 @@ void CoreState::run() {
 
             gfx.clearLayers();
 
-            if (p1game) {
-                if (!p1game->update(!button_emergency_override)) {
-                    p1game->quit(p1game);
-                    free(p1game);
-                    p1game = NULL;
-
-                    bg.transition(Shiro::ImageAsset::get(assetMgr, "bg_temp"));
-                    break;
+            {
+                Shiro::FrameProfiler::Scope scope(profiler, Shiro::FrameProfiler::Phase::update);
+                if (p1game) {
+                    if (!p1game->update(!button_emergency_override)) {
+                        p1game->quit(p1game);
+                        free(p1game);
+                        p1game = NULL;
+
+                        bg.transition(Shiro::ImageAsset::get(assetMgr, "bg_temp"));
+                        break;
+                    }
                 }
-            }
-            if (menu && ((!p1game || menu_input_override) ? 1 : 0)) {
-                if (!menu->update(!button_emergency_override)) {
-                    menu->quit(menu);
-                    free(menu);
+                if (menu && ((!p1game || menu_input_override) ? 1 : 0)) {
+                    if (!menu->update(!button_emergency_override)) {
+                        menu->quit(menu);
+                        free(menu);
 
-                    menu = NULL;
+                        menu = NULL;
 
-                    if (!p1game) {
-                        running = false;
+                        if (!p1game) {
+                            running = false;
+                        }
                     }
                 }
             }
@@ -682,7 +699,30 @@ void CoreState::run() {
                 [this] { gfx_drawbuttons(this, EMERGENCY_OVERRIDE); }
             ));
 
-            gfx.update();
+            if (profiler.enabled()) {
+                gfx.push(std::make_unique<OldGfxEntity>(
+                    Shiro::GfxLayer::emergencyAnimations,
+                    [this] {
+                        const auto stats = profiler.stats(RECENT_FRAMES);
+                        char line[64];
+                        int y = 4;
+                        gfx_drawtext(this, "PHASE          AVG MS  MAX MS", 4, y, monofont_tiny, NULL);
+                        for (std::size_t i = 0u; i < stats.size(); i++) {
+                            y += 8;
+                            std::snprintf(line, sizeof(line), "%-14s %6.3f  %6.3f",
+                                Shiro::FrameProfiler::name(static_cast<Shiro::FrameProfiler::Phase>(i)),
+                                stats[i].averageMs,
+                                stats[i].maxMs);
+                            gfx_drawtext(this, line, 4, y, monofont_tiny, NULL);
+                        }
+                    }
+                ));
+            }
+
+            {
+                Shiro::FrameProfiler::Scope scope(profiler, Shiro::FrameProfiler::Phase::gfxUpdate);
+                gfx.update();
+            }
 
 #ifndef DEBUG_FRAME_TIMING
             gameFrameTime = 1.0 / fps;
@@ -715,9 +755,17 @@ void CoreState::run() {
         SDL_SetRenderTarget(screen.renderer, screen.target_tex);
         SDL_RenderClear(screen.renderer);
 
-        bg.draw();
-        gfx.draw();
+        {
+            Shiro::FrameProfiler::Scope scope(profiler, Shiro::FrameProfiler::Phase::bgDraw);
+            bg.draw();
+        }
+        {
+            Shiro::FrameProfiler::Scope scope(profiler, Shiro::FrameProfiler::Phase::gfxDraw);
+            gfx.draw();
+        }
 
+        std::optional<Shiro::FrameProfiler::Scope> presentScope;
+        presentScope.emplace(profiler, Shiro::FrameProfiler::Phase::present);
 #ifdef ENABLE_OPENGL_INTERPOLATION
         if (settings.interpolate) {
             SDL_RenderFlush(screen.renderer);
@@ -780,6 +828,7 @@ void CoreState::run() {
 #else
         SDL_RenderPresent(screen.renderer);
 #endif
+        presentScope.reset();
 
 #if 0
         if (newFrames > 0u) {
@@ -833,6 +882,8 @@ void CoreState::load_files() {
 
 void quit(CoreState *cs)
 {
+    // writes whatever's still queued
+    cs->recordWriter.stop();
     scoredb_terminate(&cs->records);
     // scoredb_terminate(&cs->archive);
 
@@ -1198,6 +1249,30 @@ bool CoreState::process_events() {
                     motionBlur = !motionBlur;
                     break;
 
+                case SDLK_F10:
+                    if (keyMod & KMOD_SHIFT) {
+                        profiler.writeTraceAsync("shiromino-trace-" + std::to_string(std::time(nullptr)) + ".json");
+                    }
+                    else {
+                        profiler.setEnabled(!profiler.enabled());
+                    }
+                    break;
+
+                case SDLK_PAGEUP:
+                    replay_seek_steps--;
+                    break;
+
+                case SDLK_PAGEDOWN:
+                    replay_seek_steps++;
+                    break;
+
+                case SDLK_TAB:
+                    // some bindings use Tab (the second preset's start); those players get the key, not fast-forward
+                    if (!keyBindings.binds(keyCode)) {
+                        replay_fast_forward = true;
+                    }
+                    break;
+
                 case SDLK_F11:
                     if (settings.fullscreen) {
                         settings.fullscreen = false;
@@ -1292,6 +1367,10 @@ bool CoreState::process_events() {
 #undef CHECK_KEYUP
 
                 switch (keyCode) {
+                case SDLK_TAB:
+                    replay_fast_forward = false;
+                    break;
+
                 case SDLK_LEFT:
                     left_arrow_das = 0;
                     break;
@@ -1554,7 +1633,11 @@ void CoreState::handle_replay_input() {
         }
 
         if (q->playback) {
-            if ((unsigned int)(q->playback_index) == q->replay->len) {
+            if (q->keyframes) {
+                q->keyframes->capture(*this, *g);
+            }
+
+            if ((std::size_t)(q->playback_index) == q->replay->pinputs.size()) {
                 qrs_end_playback(g);
             }
             else {
@@ -1564,11 +1647,38 @@ void CoreState::handle_replay_input() {
             }
         }
         else if(q->recording) {
-            q->replay->pinputs[q->replay->len] = pack_input(&keys_raw);
+            q->replay->pinputs.push_back(pack_input(&keys_raw));
+        }
+    }
+}
+
+void CoreState::handle_replay_seek() {
+    game_t *g = p1game;
+    qrsdata *q = g ? (qrsdata *)g->data : NULL;
+
+    if (q == NULL || !q->playback || q->keyframes == NULL) {
+        replay_seek_steps = 0;
+        return;
+    }
 
-            q->replay->len++;
+    // digits jump to the start of a section
+    for (int i = 0; i < 10; i++) {
+        if (pressedDigits[i]) {
+            pressedDigits[i] = false;
+            q->keyframes->seekSection(*this, *g, i);
+            return;
         }
     }
+
+    if (replay_seek_steps != 0) {
+        long target = q->playback_index + long(replay_seek_steps) * REPLAY_SEEK_STEP;
+        replay_seek_steps = 0;
+        q->keyframes->seek(*this, *g, target < 0 ? 0u : unsigned(target));
+    }
+    else if (replay_fast_forward) {
+        // the extra frames are simulated; only the frame after them is shown
+        q->keyframes->seek(*this, *g, unsigned(q->playback_index) + (REPLAY_FAST_FORWARD_RATE - 1));
+    }
 }
 
 void CoreState::update_input_repeat() {
@@ -26,9 +26,12 @@
 #include "Menu/ToggleOption.h"
 #include "RefreshRates.h"
 #include "replay.h"
+#include "Timer.h"
 #include <cstdlib>
 #include <ctime>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 Shiro::MenuOption std_game_multiopt_create(CoreState *cs, unsigned int mode, int num_sections, std::string label)
 {
     Shiro::MenuOption m = Shiro::create_menu_option(Shiro::ElementType::MENU_GAME_MULTIOPT, NULL, label);
@@ -357,6 +360,8 @@ game_t *menu_create(CoreState *cs)
     d->is_paged = 0;
     d->page = 0;
     d->page_length = 0;
+    d->page_count = 0;
+    d->load_page = NULL;
     d->page_text_x = 0;
     d->page_text_y = 0;
     d->title = "";
@@ -469,7 +474,7 @@ int menu_input(game_t *g)
         update = 1;
         for(i = d->selection - 1;; i--)
         {
-            if(d->is_paged)
+            if(d->is_paged && !d->load_page)
             {
                 if(d->selection == d->page * d->page_length)
                 {
@@ -524,7 +529,7 @@ int menu_input(game_t *g)
         update = 1;
         for(i = d->selection + 1;; i++)
         {
-            if(d->is_paged)
+            if(d->is_paged && !d->load_page)
             {
                 if(d->selection == (d->page + 1) * d->page_length - 1)
                 {
@@ -582,7 +587,26 @@ int menu_input(game_t *g)
         }
     }
 
-    if(d->is_paged)
+    if(d->is_paged && d->load_page)
+    {
+        const int page = d->page;
+        const int selection = d->selection;
+
+        if((cs->pressed.left || cs->is_left_input_repeat(DAS)) && page > 0)
+        {
+            update = 1;
+            d->load_page(g, page - 1);
+        }
+        else if((cs->pressed.right || cs->is_right_input_repeat(DAS)) && page < d->page_count - 1)
+        {
+            update = 1;
+            d->load_page(g, page + 1);
+        }
+
+        if(d->page != page)
+            d->selection = selection < d->numopts ? selection : d->numopts - 1;
+    }
+    else if(d->is_paged)
     {
         if((cs->pressed.left || cs->is_left_input_repeat(DAS)) && d->page > 0)
         {
@@ -872,6 +896,7 @@ int menu_clear(game_t *g)
     d->selection = 0;
     d->numopts = 0;
     d->is_paged = 0;
+    d->load_page = NULL;
 
     return 0;
 }
@@ -1042,6 +1067,14 @@ int mload_main(game_t *g, int val)
     m->x = 4 * 16;
     m->y = 14 * 16;
 
+    d->menu.push_back(Shiro::create_menu_option(Shiro::ElementType::MENU_ACTION, NULL, "RECORDS"));
+    m = &d->menu.back();
+    d1 = (Shiro::ActionOptionData *)m->data;
+    d1->action = mload_records;
+    d1->val = 0;
+    m->x = 4 * 16;
+    m->y = 15 * 16;
+
     d->menu.push_back(Shiro::create_menu_option(Shiro::ElementType::MENU_LABEL, NULL, "SETTINGS"));
     m = &d->menu.back();
     m->x = 4 * 16;
@@ -1718,16 +1751,61 @@ int mload_options(game_t *g, int val)
 
 #define BUF_SIZE 64
 
+// a MENU_GAME option's arguments for watching the replay of a score
+static void set_replay_game_args(Shiro::GameOptionData *d4, CoreState *cs, const Shiro::ReplayDescriptor &r)
+{
+    d4->mode = QUINTESSE;
+    d4->args.num = 4;
+    d4->args.ptrs = (void **)malloc(4 * sizeof(void *));
+    assert(d4->args.ptrs != nullptr);
+    d4->args.ptrs[0] = malloc(sizeof(CoreState *));
+    d4->args.ptrs[1] = malloc(sizeof(int));
+    d4->args.ptrs[2] = malloc(sizeof(unsigned int));
+    d4->args.ptrs[3] = malloc(sizeof(int));
+    assert(
+        d4->args.ptrs[0] != nullptr &&
+        d4->args.ptrs[1] != nullptr &&
+        d4->args.ptrs[2] != nullptr &&
+        d4->args.ptrs[3] != nullptr
+    );
+    *(CoreState **)(d4->args.ptrs[0]) = cs;
+    *(int *)(d4->args.ptrs[1]) = 0;
+    *(unsigned int *)(d4->args.ptrs[2]) = r.mode;
+    *(int *)(d4->args.ptrs[3]) = r.scoreId;
+}
+
 int mload_replay(game_t *g, int val)
 {
     menudata *d = (menudata *)(g->data);
     Shiro::MenuOption *m = NULL;
     Shiro::ActionOptionData *d1 = NULL;
-    Shiro::GameOptionData *d4 = NULL;
 
-    struct replay *r = NULL;
-    int replayCount = 0;
-    struct replay *replaylist = scoredb_get_replay_list(&g->origin->records, &g->origin->player, &replayCount);
+    // every page starts with RETURN
+    const int page_length = 20;
+    const int replays_per_page = page_length - 1;
+
+    std::vector<Shiro::ReplayDescriptor> &page_keys = d->replay_menu_data.page_keys;
+    if(val <= 0)
+    {
+        val = 0;
+        page_keys.clear();
+    }
+    else if(val > int(page_keys.size()))
+        val = int(page_keys.size());
+
+    // so the list has the game that just ended
+    g->origin->recordWriter.flush();
+
+    const int replayCount = scoredb_get_replay_count(&g->origin->records, &g->origin->player);
+    const std::vector<Shiro::ReplayDescriptor> replays = scoredb_get_replay_page(
+        &g->origin->records,
+        &g->origin->player,
+        val > 0 ? &page_keys[val - 1] : NULL,
+        replays_per_page
+    );
+
+    if(int(page_keys.size()) == val && !replays.empty())
+        page_keys.push_back(replays.back());
 
     menu_clear(g); // data->menu guaranteed to be NULL upon return
 
@@ -1740,58 +1818,151 @@ int mload_replay(game_t *g, int val)
     d->y = 16;
 
     d->is_paged = 1;
-    d->page = 0;
-    d->page_length = 20;
+    d->page = val;
+    d->page_length = page_length;
+    d->page_count = replayCount > 0 ? (replayCount + replays_per_page - 1) / replays_per_page : 1;
+    d->load_page = mload_replay;
     d->page_text_x = 640 - 16;
     d->page_text_y = 16;
 
-    if(replaylist)
+    d->numopts = int(replays.size()) + 1;
+    d->menu.resize(d->numopts);
+    d->menu[0] = Shiro::create_menu_option(Shiro::ElementType::MENU_ACTION, NULL, "RETURN");
+    m = &d->menu[0];
+    d1 = (Shiro::ActionOptionData *)m->data;
+    d1->action = mload_main;
+    d1->val = 0;
+    m->x = 20;
+    m->y = 60;
+    m->label_text_flags = DRAWTEXT_THIN_FONT;
+
+    for(int i = 1; i < d->numopts; i++)
     {
-        d->numopts = replayCount + 1;
-        d->menu.resize(d->numopts);
-        d->menu[0] = Shiro::create_menu_option(Shiro::ElementType::MENU_ACTION, NULL, "RETURN");
-        m = &d->menu[0];
-        d1 = (Shiro::ActionOptionData *)m->data;
-        d1->action = mload_main;
-        d1->val = 0;
-        m->x = 20;
-        m->y = 60;
+        const Shiro::ReplayDescriptor &r = replays[i - 1];
+
+        d->menu[i] = Shiro::create_menu_option(Shiro::ElementType::MENU_GAME, NULL, "");
+        d->menu[i].label = get_replay_descriptor(r);
+        m = &d->menu[i];
+        set_replay_game_args((Shiro::GameOptionData *)m->data, g->origin, r);
+        m->x = 20 - 13;
+        m->y = 60 + i * 20;
         m->label_text_flags = DRAWTEXT_THIN_FONT;
+        m->label_text_rgba = (i % 2) ? 0xA0A0FFFF : RGBA_DEFAULT;
+    }
 
-        for(int i = 1; i < replayCount + 1; i++)
-        {
-            d->menu[i] = Shiro::create_menu_option(Shiro::ElementType::MENU_GAME, NULL, "");
-            r = &replaylist[i - 1];
-
-            d->menu[i].label = get_replay_descriptor(r);
-            m = &d->menu[i];
-            d4 = (Shiro::GameOptionData *)m->data;
-            d4->mode = QUINTESSE;
-            d4->args.num = 4;
-            d4->args.ptrs = (void **)malloc(4 * sizeof(void *));
-            assert(d4->args.ptrs != nullptr);
-            d4->args.ptrs[0] = malloc(sizeof(CoreState *));
-            d4->args.ptrs[1] = malloc(sizeof(int));
-            d4->args.ptrs[2] = malloc(sizeof(unsigned int));
-            d4->args.ptrs[3] = malloc(sizeof(int));
-            assert(
-                d4->args.ptrs[0] != nullptr &&
-                d4->args.ptrs[1] != nullptr &&
-                d4->args.ptrs[2] != nullptr &&
-                d4->args.ptrs[3] != nullptr
-            );
-            *(CoreState **)(d4->args.ptrs[0]) = g->origin;
-            *(int *)(d4->args.ptrs[1]) = 0;
-            *(unsigned int *)(d4->args.ptrs[2]) = r->mode;
-            *(int *)(d4->args.ptrs[3]) = r->index;
-            m->x = 20 - 13;
-            m->y = 60 + (i % 20) * 20;
-            m->label_text_flags = DRAWTEXT_THIN_FONT;
-            m->label_text_rgba = (i % 2) ? 0xA0A0FFFF : RGBA_DEFAULT;
-        }
+    return 0;
+}
+
+int mload_records(game_t *g, int val)
+{
+    menudata *d = (menudata *)(g->data);
+    Shiro::MenuOption *m = NULL;
+    Shiro::ActionOptionData *d1 = NULL;
+
+    // so the bests count the game that just ended
+    g->origin->recordWriter.flush();
+
+    const std::vector<Shiro::ReplayDescriptor> bests = scoredb_get_personal_bests(&g->origin->records, &g->origin->player);
+
+    menu_clear(g); // data->menu guaranteed to be NULL upon return
+
+    d->menu_id = MENU_ID_RECORDS;
+    d->use_target_tex = 1;
+    d->selection = 0;
+    d->title = "PERSONAL BESTS";
+    d->x = 20;
+    d->y = 16;
+
+    d->numopts = int(bests.size()) + 1;
+    d->menu.resize(d->numopts);
+    d->menu[0] = Shiro::create_menu_option(Shiro::ElementType::MENU_ACTION, NULL, "RETURN");
+    m = &d->menu[0];
+    d1 = (Shiro::ActionOptionData *)m->data;
+    d1->action = mload_main;
+    d1->val = 0;
+    m->x = 20;
+    m->y = 60;
+    m->label_text_flags = DRAWTEXT_THIN_FONT;
+
+    // one per mode played; picking one shows the mode's leaderboard
+    for(int i = 1; i < d->numopts; i++)
+    {
+        const Shiro::ReplayDescriptor &r = bests[i - 1];
+
+        d->menu[i] = Shiro::create_menu_option(Shiro::ElementType::MENU_ACTION, NULL, "");
+        d->menu[i].label = get_replay_descriptor(r);
+        m = &d->menu[i];
+        d1 = (Shiro::ActionOptionData *)m->data;
+        d1->action = mload_leaderboard;
+        d1->val = r.mode;
+        m->x = 20 - 13;
+        m->y = 60 + i * 20;
+        m->label_text_flags = DRAWTEXT_THIN_FONT;
+        m->label_text_rgba = (i % 2) ? 0xA0A0FFFF : RGBA_DEFAULT;
     }
 
-    delete[] replaylist;
+    return 0;
+}
+
+int mload_leaderboard(game_t *g, int mode)
+{
+    menudata *d = (menudata *)(g->data);
+    Shiro::MenuOption *m = NULL;
+    Shiro::ActionOptionData *d1 = NULL;
+
+    // as many players as fit under RETURN
+    const int board_length = 19;
+
+    const std::vector<Shiro::LeaderboardEntry> board = scoredb_get_leaderboard(&g->origin->records, mode, board_length);
+
+    menu_clear(g); // data->menu guaranteed to be NULL upon return
+
+    d->menu_id = MENU_ID_RECORDS;
+    d->use_target_tex = 1;
+    d->selection = 0;
+    d->title = "LEADERBOARD";
+    d->x = 20;
+    d->y = 16;
+
+    d->numopts = int(board.size()) + 1;
+    d->menu.resize(d->numopts);
+    d->menu[0] = Shiro::create_menu_option(Shiro::ElementType::MENU_ACTION, NULL, "RETURN");
+    m = &d->menu[0];
+    d1 = (Shiro::ActionOptionData *)m->data;
+    d1->action = mload_records;
+    d1->val = 0;
+    m->x = 20;
+    m->y = 60;
+    m->label_text_flags = DRAWTEXT_THIN_FONT;
+
+    // a player's best replay doesn't fit next to their name, so the rows leave out the mode and date
+    for(int i = 1; i < d->numopts; i++)
+    {
+        const Shiro::LeaderboardEntry &entry = board[i - 1];
+        const Shiro::ReplayDescriptor &r = entry.score;
+        Shiro::Timer t(60.0, r.time);
+
+        std::stringstream label;
+        label <<
+            std::setfill(' ') << std::right << std::setw(2) << i << "  " <<
+            std::left << std::setw(12) << entry.playerName.substr(0, 12) << "  " <<
+            get_grade_name(r.grade) << "  " <<
+            std::right << std::setw(4) << r.startingLevel << "-" <<
+            std::left << std::setw(4) << r.endingLevel << "  " <<
+            std::setfill('0') << std::right <<
+            std::setw(2) << t.min() << ":" <<
+            std::setw(2) << t.sec() % 60 << ":" <<
+            std::setw(2) << t.csec() % 100;
+
+        d->menu[i] = Shiro::create_menu_option(Shiro::ElementType::MENU_GAME, NULL, "");
+        d->menu[i].label = label.str();
+        m = &d->menu[i];
+        set_replay_game_args((Shiro::GameOptionData *)m->data, g->origin, r);
+        m->x = 20 - 13;
+        m->y = 60 + i * 20;
+        m->label_text_flags = DRAWTEXT_THIN_FONT;
+        m->label_text_rgba = (i % 2) ? 0xA0A0FFFF : RGBA_DEFAULT;
+    }
 
     return 0;
 }
@@ -4,11 +4,13 @@
 #include "CoreState.h"
 #include "Game.h"
 #include "Menu/Option.h"
+#include "replay.h"
 
 #define MENU_PRACTICE_NUMOPTS 15
 #define MENU_ID_MAIN 0
 #define MENU_ID_PRACTICE 1
 #define MENU_ID_REPLAY 2
+#define MENU_ID_RECORDS 3
 
 struct menudata
 {
@@ -16,6 +18,7 @@ struct menudata
         menu_id(0),
         main_menu_data({ 0, 0 }),
         practice_menu_data({ nullptr, 0 }),
+        replay_menu_data(),
         target_tex(nullptr),
         use_target_tex(0),
         numopts(0),
@@ -23,6 +26,8 @@ struct menudata
         is_paged(0),
         page(0),
         page_length(0),
+        page_count(0),
+        load_page(nullptr),
         page_text_x(0),
         page_text_y(0),
         x(0),
@@ -43,6 +48,12 @@ struct menudata
         int selection;
     } practice_menu_data;
 
+    struct
+    {
+        // the last replay of each page before the one shown, to continue the list from
+        std::vector<Shiro::ReplayDescriptor> page_keys;
+    } replay_menu_data;
+
     SDL_Texture *target_tex;
     int use_target_tex;
     int numopts;
@@ -52,6 +63,12 @@ struct menudata
     int page;
     int page_length;
 
+    // Paged menus with load_page set only hold the options of the page
+    // shown, out of page_count pages; load_page replaces them with
+    // another page's.
+    int page_count;
+    int (*load_page)(game_t *g, int page);
+
     int page_text_x;
     int page_text_y;
 
@@ -85,6 +102,8 @@ int menu_clear(game_t *g);
 int mload_main(game_t *g, int val);
 int mload_practice(game_t *g, int val);
 int mload_replay(game_t *g, int val);
+int mload_records(game_t *g, int val);
+int mload_leaderboard(game_t *g, int mode);
 int mload_options(game_t *g, int val);
 
 int menu_action_quit(game_t *g, int val);
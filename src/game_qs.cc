@@ -1,13 +1,11 @@
 #include "Debug.h"
 #include "CoreState.h"
-#include "Asset/Music.h"
-#include "Asset/Sfx.h"
 #include "game_menu.h"
 #include "game_qs.h"
 #include "GameType.h"
-#include "Video/MessageEntity.h"
 #include "gfx_old.h"
 #include "gfx_qs.h"
+#include "PracticeRewind.h"
 #include "QRS0.h"
 #include "Menu/ElementType.h"
 #include "Menu/TextOption.h"
@@ -454,42 +452,44 @@ static int find_music(int level, const struct levelmusic *table)
     return music;
 }
 
-static void play_or_halt_music(qrsdata *q, CoreState *cs, const std::filesystem::path& tracks, int desired_music)
+static void play_or_halt_music(game_t *g, const std::filesystem::path& tracks, int desired_music)
 {
+    qrsdata *q = (qrsdata *)g->data;
     if(q->music == desired_music)
         return;
 
     q->music = desired_music;
-    std::cerr << "Music: " << q->music << std::endl;
-    if(desired_music == -1)
-        Mix_HaltMusic();
-    else
-        MusicAsset::get(cs->assetMgr, tracks, desired_music).play(cs->settings);
+    if(g->sink)
+    {
+        std::cerr << "Music: " << q->music << std::endl;
+        g->sink->playMusic(tracks, desired_music);
+    }
 }
 
-static void update_music(qrsdata *q, CoreState *cs)
+static void update_music(game_t *g)
 {
+    qrsdata *q = (qrsdata *)g->data;
     switch(q->mode_type)
     {
         case MODE_PENTOMINO:
-            play_or_halt_music(q, cs, "tracks", find_music(q->level, pentomino_music));
+            play_or_halt_music(g, "tracks", find_music(q->level, pentomino_music));
             break;
 
         case MODE_G2_MASTER:
-            play_or_halt_music(q, cs, "g2_tracks", find_music(q->level, g2_master_music));
+            play_or_halt_music(g, "g2_tracks", find_music(q->level, g2_master_music));
             break;
 
         case MODE_G2_DEATH:
-            play_or_halt_music(q, cs, "g2_tracks", find_music(q->level, g2_death_music));
+            play_or_halt_music(g, "g2_tracks", find_music(q->level, g2_death_music));
             break;
 
         case MODE_G3_TERROR:
-            play_or_halt_music(q, cs, "g3_tracks", find_music(q->level, g3_terror_music));
+            play_or_halt_music(g, "g3_tracks", find_music(q->level, g3_terror_music));
             break;
 
         case MODE_G1_MASTER:
         case MODE_G1_20G:
-            play_or_halt_music(q, cs, "g1_tracks", find_music(q->level, g1_music));
+            play_or_halt_music(g, "g1_tracks", find_music(q->level, g1_music));
             break;
 
         default:
@@ -498,6 +498,56 @@ static void update_music(qrsdata *q, CoreState *cs)
     }
 }
 
+void qs_sync_music(game_t *g)
+{
+    update_music(g);
+}
+
+// every static speed curve, in the order their entries are numbered by qs_speeds_index
+static const struct
+{
+    QRS_Timings *curve;
+    int len;
+} speed_curves[] =
+{
+    { qs_curve, QS_CURVE_MAX },
+    { g1_master_curve, G1_MASTER_CURVE_MAX },
+    { g2_master_curve, G2_MASTER_CURVE_MAX },
+    { g2_death_curve, G2_DEATH_CURVE_MAX },
+    { g3_terror_curve, G3_TERROR_CURVE_MAX }
+};
+
+int qs_speeds_index(const QRS_Timings *speeds)
+{
+    int index = 0;
+
+    for(const auto &c : speed_curves)
+    {
+        if(speeds >= c.curve && speeds < c.curve + c.len)
+            return index + int(speeds - c.curve);
+
+        index += c.len;
+    }
+
+    return -1;
+}
+
+QRS_Timings *qs_speeds_from_index(int index)
+{
+    if(index < 0)
+        return NULL;
+
+    for(const auto &c : speed_curves)
+    {
+        if(index < c.len)
+            return &c.curve[index];
+
+        index -= c.len;
+    }
+
+    return NULL;
+}
+
 game_t *qs_game_create(CoreState *cs, int level, unsigned int flags, int replay_id)
 {
     game_t *g = (game_t *)malloc(sizeof(game_t));
@@ -505,6 +555,7 @@ game_t *qs_game_create(CoreState *cs, int level, unsigned int flags, int replay_
     qrs_player *p = NULL;
 
     g->origin = cs;
+    g->sink = &cs->sink;
     g->field = new Shiro::Grid(QRS_FIELD_W, QRS_FIELD_H);
 
     g->init = qs_game_init;
@@ -521,7 +572,7 @@ game_t *qs_game_create(CoreState *cs, int level, unsigned int flags, int replay_
 
     q->mode_flags = flags;
 
-    q->piecepool = qrspool_create();
+    q->piecepool = qrspool_get(false);
     q->timer = Shiro::Timer(60.0);
     q->p1 = (qrs_player *)malloc(sizeof(qrs_player));
     p = q->p1;
@@ -566,6 +617,7 @@ game_t *qs_game_create(CoreState *cs, int level, unsigned int flags, int replay_
         q->replay = NULL;
     }
 
+    q->keyframes = NULL;
     q->recording = 0;
     q->playback = 0;
     q->playback_index = 0;
@@ -624,6 +676,7 @@ game_t *qs_game_create(CoreState *cs, int level, unsigned int flags, int replay_
     {
         q->section_times[i] = -1;
         q->section_tetrises[i] = 0;
+        q->best_section_times[i] = -1;
     }
 
     if(flags & MODE_G2_DEATH)
@@ -712,7 +765,7 @@ game_t *qs_game_create(CoreState *cs, int level, unsigned int flags, int replay_
         q->max_floorkicks = 0;
         q->special_irs = 0;
         q->lock_protect = 0;
-        q->piecepool[QRS_I4].flags = static_cast<Shiro::PieceDefinitionFlag>(q->piecepool[QRS_I4].flags | Shiro::PDNOWKICK);
+        q->piecepool = qrspool_get(true);
         cs->request_fps(Shiro::RefreshRates::g1);
     }
 
@@ -724,7 +777,7 @@ game_t *qs_game_create(CoreState *cs, int level, unsigned int flags, int replay_
         q->num_previews = 1;
         q->max_floorkicks = 0;
         q->special_irs = 0;
-        q->piecepool[QRS_I4].flags = static_cast<Shiro::PieceDefinitionFlag>(q->piecepool[QRS_I4].flags | Shiro::PDNOWKICK);
+        q->piecepool = qrspool_get(true);
         cs->request_fps(Shiro::RefreshRates::g2);
     }
 
@@ -850,10 +903,8 @@ game_t *qs_game_create(CoreState *cs, int level, unsigned int flags, int replay_
             q->pracdata->field_w = 10;
             q->pracdata->game_type = Shiro::GameType::SIMULATE_G2;
             // q->pracdata->long_history = NULL;   // unused at the moment
-            q->pracdata->usr_seq_expand_len = 0;
-            q->pracdata->usr_seq_len = 0;
-            q->pracdata->usr_field_undo.clear();
-            q->pracdata->usr_field_redo.clear();
+            q->pracdata->usr_sequence.clear();
+            q->pracdata->usr_field_history.clear();
             q->pracdata->field_edit_in_progress = 0;
             q->pracdata->usr_field = Shiro::Grid(QRS_FIELD_W, QRS_FIELD_H);
             q->pracdata->palette_selection = -5;
@@ -957,12 +1008,12 @@ int qs_game_init(game_t *g)
 
     if(q->replay)
     {
-        *(qrand->seedp) = q->replay->seed;
+        qrand->seed = q->replay->seed;
         q->randomizer_seed = q->replay->seed;
     }
     else
     {
-        q->randomizer_seed = *(qrand->seedp);
+        q->randomizer_seed = qrand->seed;
     }
 
     std::cerr << "Random seed: " << q->randomizer_seed << std::endl;
@@ -986,7 +1037,7 @@ int qs_game_init(game_t *g)
     }
 
     q->previews.clear();
-    if(q->pracdata && q->pracdata->usr_seq_len)
+    if(q->pracdata && !q->pracdata->usr_sequence.empty())
     {
         for (size_t i = 0; i < 4; i++) {
             int elem = qs_get_usrseq_elem(q->pracdata, i);
@@ -1031,7 +1082,8 @@ int qs_game_init(game_t *g)
 
     q->p1->state = PSFALL;
 
-    if(!ImageAsset::get(g->origin->assetMgr, "bg", 0).loaded()) // used to check if we are in a testing environment
+    // headless games have no backgrounds; an unloaded bg is used to check if we are in a testing environment
+    if(!g->sink || !ImageAsset::get(g->origin->assetMgr, "bg", 0).loaded())
         return 0;
 
     int bgnumber = q->section;
@@ -1040,7 +1092,7 @@ int qs_game_init(game_t *g)
 
     if(!q->pracdata)
     {
-        g->origin->bg.transition(ImageAsset::get(g->origin->assetMgr, "bg", bgnumber));
+        g->sink->transitionBackground(bgnumber);
 
         if(q->mode_type == MODE_G2_DEATH)
         {
@@ -1071,7 +1123,7 @@ int qs_game_pracinit(game_t *g, int val)
 
     cs->menu_input_override = 0;
 
-    q->randomizer_seed = *(qrand->seedp);
+    q->randomizer_seed = qrand->seed;
     q->using_gems = false;
 
     q->pracdata->usr_field = *g->field;
@@ -1127,7 +1179,7 @@ int qs_game_pracinit(game_t *g, int val)
         next4_id = ars_to_qrs_id(next4_id);
     }
 
-    if(q->pracdata->usr_seq_len)
+    if(!q->pracdata->usr_sequence.empty())
     {
         for (size_t i = 0; i < 4; i++) {
             int elem = qs_get_usrseq_elem(q->pracdata, i);
@@ -1174,6 +1226,11 @@ int qs_game_pracinit(game_t *g, int val)
     q->level = 0;
     q->pracdata->paused = 0;
 
+    if(q->pracdata->rewind)
+        q->pracdata->rewind->clear();
+    else
+        q->pracdata->rewind = new Shiro::PracticeRewind(static_cast<std::size_t>(cs->settings.practiceRewindMemory) * 1024u);
+
     return 0;
 }
 
@@ -1194,7 +1251,8 @@ int qs_game_quit(game_t *g)
     if(q)
         qrsdata_destroy(q);
 
-    Mix_HaltMusic();
+    if(g->sink)
+        g->sink->haltMusic();
 
     // mostly a band-aid for quitting practice tool properly, so menu input does not take priority for regular modes
     g->origin->menu_input_override = 0;
@@ -1251,23 +1309,6 @@ int qs_game_frame(game_t *g)
     {
         if(c->init == 0 || c->init == 60)
         {
-            struct text_formatting fmt = text_fmt_create(0, 0x00FF00FF, 0);
-            fmt.size_multiplier = 2.0;
-            fmt.outlined = false;
-            if(q->pracdata)
-                fmt.outlined = true;
-
-            fmt.outline_rgba = 0x00000080;
-
-            const auto gameIsInactive = [cs]() {
-                if (cs->p1game == nullptr || cs->p1game->data == nullptr) {
-                    return true;
-                }
-
-                const qrsdata* const q = static_cast<qrsdata*>(cs->p1game->data);
-                return q->pracdata != nullptr && q->pracdata->paused == QRS_FIELD_EDIT;
-            };
-
             if(c->init == 0)
             {
                 // Start recording/playback immediately
@@ -1283,41 +1324,20 @@ int qs_game_frame(game_t *g)
                     }
                 }
 
-                MessageEntity::push(cs->gfx,
-                    FontAsset::get(cs->assetMgr, "fixedsys"),
-                    "READY",
-                    q->fieldPos->first,
-                    q->fieldPos->second,
-                    4 * 16 + 8,
-                    11 * 16,
-                    2.0f,
-                    fmt.rgba,
-                    60u,
-                    GfxLayer::messages,
-                    gameIsInactive
-                );
-
-                SfxAsset::get(cs->assetMgr, "ready").play(cs->settings);
+                if(g->sink)
+                {
+                    g->sink->pushMessage("READY", q->fieldPos->first, q->fieldPos->second, 4 * 16 + 8, 11 * 16, 2.0f, 0x00FF00FF, 60u);
+                    g->sink->playSfx("ready");
+                }
             }
 
             else if(c->init == 60)
             {
-                fmt.rgba = 0xFF0000FF;
-                MessageEntity::push(cs->gfx,
-                    FontAsset::get(cs->assetMgr, "fixedsys"),
-                    "GO",
-                    q->fieldPos->first,
-                    q->fieldPos->second,
-                    6 * 16,
-                    11 * 16,
-                    2.0f,
-                    fmt.rgba,
-                    60u,
-                    GfxLayer::messages,
-                    gameIsInactive
-                );
-
-                SfxAsset::get(cs->assetMgr, "go").play(cs->settings);
+                if(g->sink)
+                {
+                    g->sink->pushMessage("GO", q->fieldPos->first, q->fieldPos->second, 6 * 16, 11 * 16, 2.0f, 0xFF0000FF, 60u);
+                    g->sink->playSfx("go");
+                }
             }
         }
 
@@ -1335,7 +1355,8 @@ int qs_game_frame(game_t *g)
         {
             qrs_lock(g, q->p1);
             (*s) = PSINACTIVE;
-            Mix_HaltMusic();
+            if(g->sink)
+                g->sink->haltMusic();
             if(q->playback)
                 qrs_end_playback(g);
             else if(q->recording)
@@ -1345,7 +1366,7 @@ int qs_game_frame(game_t *g)
 
         if(!q->pracdata)
         {
-            update_music(q, cs);
+            update_music(g);
 
             if(q->mode_type == MODE_PENTOMINO)
             {
@@ -1365,7 +1386,7 @@ int qs_game_frame(game_t *g)
     {
         // handle speed curve and music updates (this runs every frame)
         // TODO: why does this need to run every frame and not only on level updates?
-        update_music(q, cs);
+        update_music(g);
         switch(q->mode_type)
         {
             case MODE_G2_MASTER:
@@ -1519,7 +1540,8 @@ int qs_game_frame(game_t *g)
                 start_i = 0;
             }
 
-            gfx_qs_lineclear(g, row);
+            if(g->sink)
+                g->sink->lineClear(g, row);
 
             for(int i = start_i; i < start_i + q->field_w; i++)
             {
@@ -1681,19 +1703,23 @@ int qs_game_frame(game_t *g)
             {
                 case 1:
                     q->medal_re = BRONZE;
-                    SfxAsset::get(cs->assetMgr, "medal").play(cs->settings);
+                    if(g->sink)
+                        g->sink->playSfx("medal");
                     break;
                 case 2:
                     q->medal_re = SILVER;
-                    SfxAsset::get(cs->assetMgr, "medal").play(cs->settings);
+                    if(g->sink)
+                        g->sink->playSfx("medal");
                     break;
                 case 3:
                     q->medal_re = GOLD;
-                    SfxAsset::get(cs->assetMgr, "medal").play(cs->settings);
+                    if(g->sink)
+                        g->sink->playSfx("medal");
                     break;
                 case 5:
                     q->medal_re = PLATINUM;
-                    SfxAsset::get(cs->assetMgr, "medal").play(cs->settings);
+                    if(g->sink)
+                        g->sink->playSfx("medal");
                     break;
                 default:
                     break;
@@ -1812,7 +1838,8 @@ static int qs_are_expired(game_t *g)
     {
         qrs_lock(g, q->p1);
         (*s) = PSINACTIVE;
-        Mix_HaltMusic();
+        if(g->sink)
+            g->sink->haltMusic();
         if(q->playback)
             qrs_end_playback(g);
         else if(q->recording)
@@ -1926,7 +1953,6 @@ int qs_process_lineare(game_t *g)
 
 int qs_process_lineclear(game_t *g)
 {
-    CoreState *cs = g->origin;
     qrsdata *q = (qrsdata *)g->data;
     unsigned int *s = &q->p1->state;
     QRS_Counters *c = q->p1counters;
@@ -1943,7 +1969,8 @@ int qs_process_lineclear(game_t *g)
             {
                 qrs_dropfield(g);
             }
-            SfxAsset::get(cs->assetMgr, "dropfield").play(cs->settings);
+            if(g->sink)
+                g->sink->playSfx("dropfield");
 
             switch(q->mode_type)
             {
@@ -2125,7 +2152,6 @@ int qs_process_prelockflash(game_t *g)
 
 int qs_process_lockflash(game_t *g)
 {
-    CoreState *cs = g->origin;
     qrsdata *q = (qrsdata *)g->data;
     unsigned int *s = &q->p1->state;
     // qrs_counters *c = q->p1counters;
@@ -2213,7 +2239,8 @@ int qs_process_lockflash(game_t *g)
                                 if(!gradeup)
                                 {
                                     q->last_gradeup_timestamp = g->frame_counter;
-                                    SfxAsset::get(cs->assetMgr, "gradeup").play(cs->settings);
+                                    if(g->sink)
+                                        g->sink->playSfx("gradeup");
                                     gradeup = true;
                                 }
                             }
@@ -2271,7 +2298,8 @@ int qs_process_lockflash(game_t *g)
                                 if(!gradeup)
                                 {
                                     q->last_gradeup_timestamp = g->frame_counter;
-                                    SfxAsset::get(cs->assetMgr, "gradeup").play(cs->settings);
+                                    if(g->sink)
+                                        g->sink->playSfx("gradeup");
                                     gradeup = true;
                                 }
                             }
@@ -2296,7 +2324,8 @@ int qs_process_lockflash(game_t *g)
                             if(old_grade != q->grade)
                             {
                                 q->last_gradeup_timestamp = g->frame_counter;
-                                SfxAsset::get(cs->assetMgr, "gradeup").play(cs->settings);
+                                if(g->sink)
+                                    g->sink->playSfx("gradeup");
                             }
                         }
 
@@ -2336,7 +2365,8 @@ int qs_process_lockflash(game_t *g)
                         {
                             q->medal_co = BRONZE;
                             q->last_medal_co_timestamp = g->frame_counter;
-                            SfxAsset::get(cs->assetMgr, "medal").play(cs->settings);
+                            if(g->sink)
+                                g->sink->playSfx("medal");
                         }
 
                         break;
@@ -2345,7 +2375,8 @@ int qs_process_lockflash(game_t *g)
                         {
                             q->medal_co = SILVER;
                             q->last_medal_co_timestamp = g->frame_counter;
-                            SfxAsset::get(cs->assetMgr, "medal").play(cs->settings);
+                            if(g->sink)
+                                g->sink->playSfx("medal");
                         }
 
                         break;
@@ -2354,7 +2385,8 @@ int qs_process_lockflash(game_t *g)
                         {
                             q->medal_co = GOLD;
                             q->last_medal_co_timestamp = g->frame_counter;
-                            SfxAsset::get(cs->assetMgr, "medal").play(cs->settings);
+                            if(g->sink)
+                                g->sink->playSfx("medal");
                         }
 
                         break;
@@ -2363,7 +2395,8 @@ int qs_process_lockflash(game_t *g)
                         {
                             q->medal_co = PLATINUM;
                             q->last_medal_co_timestamp = g->frame_counter;
-                            SfxAsset::get(cs->assetMgr, "medal").play(cs->settings);
+                            if(g->sink)
+                                g->sink->playSfx("medal");
                         }
 
                         break;
@@ -2380,7 +2413,8 @@ int qs_process_lockflash(game_t *g)
                             {
                                 q->medal_sk = BRONZE;
                                 q->last_medal_sk_timestamp = g->frame_counter;
-                                SfxAsset::get(cs->assetMgr, "medal").play(cs->settings);
+                                if(g->sink)
+                                    g->sink->playSfx("medal");
                             }
 
                             break;
@@ -2389,7 +2423,8 @@ int qs_process_lockflash(game_t *g)
                             {
                                 q->medal_sk = SILVER;
                                 q->last_medal_sk_timestamp = g->frame_counter;
-                                SfxAsset::get(cs->assetMgr, "medal").play(cs->settings);
+                                if(g->sink)
+                                    g->sink->playSfx("medal");
                             }
 
                             break;
@@ -2398,7 +2433,8 @@ int qs_process_lockflash(game_t *g)
                             {
                                 q->medal_sk = GOLD;
                                 q->last_medal_sk_timestamp = g->frame_counter;
-                                SfxAsset::get(cs->assetMgr, "medal").play(cs->settings);
+                                if(g->sink)
+                                    g->sink->playSfx("medal");
                             }
 
                             break;
@@ -2407,7 +2443,8 @@ int qs_process_lockflash(game_t *g)
                             {
                                 q->medal_sk = PLATINUM;
                                 q->last_medal_sk_timestamp = g->frame_counter;
-                                SfxAsset::get(cs->assetMgr, "medal").play(cs->settings);
+                                if(g->sink)
+                                    g->sink->playSfx("medal");
                             }
 
                             break;
@@ -2417,7 +2454,8 @@ int qs_process_lockflash(game_t *g)
                 }
             }
 
-            SfxAsset::get(cs->assetMgr, "lineclear").play(cs->settings);
+            if(g->sink)
+                g->sink->playSfx("lineclear");
 
             if(((q->level - q->lvlinc) % 100) > 90 && (q->level % 100) < 10)
             {
@@ -2462,7 +2500,8 @@ int qs_process_lockflash(game_t *g)
                                     {
                                         q->grade = GRADE_M;
                                         q->last_gradeup_timestamp = g->frame_counter;
-                                        SfxAsset::get(cs->assetMgr, "gradeup").play(cs->settings);
+                                        if(g->sink)
+                                            g->sink->playSfx("gradeup");
                                     }
                                 }
                             }
@@ -2477,7 +2516,8 @@ int qs_process_lockflash(game_t *g)
                                 {
                                     q->grade = GRADE_GM;
                                     q->last_gradeup_timestamp = g->frame_counter;
-                                    SfxAsset::get(cs->assetMgr, "gradeup").play(cs->settings);
+                                    if(g->sink)
+                                        g->sink->playSfx("gradeup");
                                 }
 
                                 if(q->playback)
@@ -2560,7 +2600,8 @@ int qs_process_lockflash(game_t *g)
                                 {
                                     q->grade = GRADE_M;
                                     q->last_gradeup_timestamp = g->frame_counter;
-                                    SfxAsset::get(cs->assetMgr, "gradeup").play(cs->settings);
+                                    if(g->sink)
+                                        g->sink->playSfx("gradeup");
                                 }
                             }
                             else if(q->level >= 999)
@@ -2568,7 +2609,8 @@ int qs_process_lockflash(game_t *g)
                                 q->level = 999;
                                 q->grade = GRADE_GM;
                                 q->last_gradeup_timestamp = g->frame_counter;
-                                SfxAsset::get(cs->assetMgr, "gradeup").play(cs->settings);
+                                if(g->sink)
+                                    g->sink->playSfx("gradeup");
                                 if(q->playback)
                                     qrs_end_playback(g);
                                 else if(q->recording)
@@ -2589,7 +2631,8 @@ int qs_process_lockflash(game_t *g)
                             }
 
                             q->last_gradeup_timestamp = g->frame_counter;
-                            SfxAsset::get(cs->assetMgr, "gradeup").play(cs->settings);
+                            if(g->sink)
+                                g->sink->playSfx("gradeup");
 
                             if(q->section == 5)
                             {
@@ -2641,7 +2684,8 @@ int qs_process_lockflash(game_t *g)
                                 {
                                     q->grade = GRADE_GM;
                                     q->last_gradeup_timestamp = g->frame_counter;
-                                    SfxAsset::get(cs->assetMgr, "gradeup").play(cs->settings);
+                                    if(g->sink)
+                                        g->sink->playSfx("gradeup");
                                 }
 
                                 if(q->playback)
@@ -2657,10 +2701,12 @@ int qs_process_lockflash(game_t *g)
                             break;
                     }
 
-                    SfxAsset::get(cs->assetMgr, "newsection").play(cs->settings);
+                    if(g->sink)
+                        g->sink->playSfx("newsection");
                     if(q->section < 13)
                     {
-                        cs->bg.transition(ImageAsset::get(cs->assetMgr, "bg", q->section));
+                        if(g->sink)
+                            g->sink->transitionBackground(q->section);
                     }
                 }
             }
@@ -2680,7 +2726,8 @@ int qs_process_lockflash(game_t *g)
                     case MODE_G2_DEATH:
                         q->grade = GRADE_GM;
                         q->last_gradeup_timestamp = g->frame_counter;
-                        SfxAsset::get(cs->assetMgr, "gradeup").play(cs->settings);
+                        if(g->sink)
+                            g->sink->playSfx("gradeup");
                         if(q->playback)
                             qrs_end_playback(g);
                         else if(q->recording)
@@ -2701,7 +2748,8 @@ int qs_process_lockflash(game_t *g)
                         {
                             q->grade = GRADE_GM;
                             q->last_gradeup_timestamp = g->frame_counter;
-                            SfxAsset::get(cs->assetMgr, "gradeup").play(cs->settings);
+                            if(g->sink)
+                                g->sink->playSfx("gradeup");
                         }
 
                         if(q->playback)
@@ -2779,11 +2827,8 @@ so there aren't so many awkward overlapping functions
 need to break this up into multiple functions which each update exactly one
 thing
 
-split up pieceseq parser into: parsing function, expansion function, and
-get_usrseq_elem
-
-get_elem should return failure if q->pracdata->usr_seq_expand is NULL and it
-should not modify state
+split the pieceseq parser out of this function (expansion is done by
+Shiro::UserSequence)
 */
 
 int qs_update_pracdata(CoreState *cs)
@@ -2797,7 +2842,7 @@ int qs_update_pracdata(CoreState *cs)
     std::string seqStr;
     char name_str[3] = {0, 0, 0};
 
-    int piece_seq[3000];
+    std::vector<int> piece_seq;
     std::size_t num = 0;
 
     std::size_t i = 0;
@@ -2829,7 +2874,7 @@ int qs_update_pracdata(CoreState *cs)
             q->hold_enabled = 0;
             q->max_floorkicks = 2;
             q->lock_protect = 1;
-            q->piecepool[QRS_I4].flags = static_cast<Shiro::PieceDefinitionFlag>(q->piecepool[QRS_I4].flags & ~Shiro::PDNOWKICK);
+            q->piecepool = qrspool_get(false);
             q->tetromino_only = 0;
             q->pentomino_only = 0;
             cs->request_fps(Shiro::RefreshRates::pentomino);
@@ -2844,7 +2889,7 @@ int qs_update_pracdata(CoreState *cs)
             q->hold_enabled = 0;
             q->max_floorkicks = 0;
             q->lock_protect = 0;
-            q->piecepool[QRS_I4].flags = static_cast<Shiro::PieceDefinitionFlag>(q->piecepool[QRS_I4].flags | Shiro::PDNOWKICK);
+            q->piecepool = qrspool_get(true);
             q->tetromino_only = 1;
             q->pentomino_only = 0;
             cs->request_fps(Shiro::RefreshRates::g1);
@@ -2859,7 +2904,7 @@ int qs_update_pracdata(CoreState *cs)
             q->hold_enabled = 0;
             q->max_floorkicks = 0;
             q->lock_protect = 1;
-            q->piecepool[QRS_I4].flags = static_cast<Shiro::PieceDefinitionFlag>(q->piecepool[QRS_I4].flags | Shiro::PDNOWKICK);
+            q->piecepool = qrspool_get(true);
             q->tetromino_only = 1;
             q->pentomino_only = 0;
             cs->request_fps(Shiro::RefreshRates::g2);
@@ -2874,7 +2919,7 @@ int qs_update_pracdata(CoreState *cs)
             q->hold_enabled = 1;
             q->max_floorkicks = 1;
             q->lock_protect = 1;
-            q->piecepool[QRS_I4].flags = static_cast<Shiro::PieceDefinitionFlag>(q->piecepool[QRS_I4].flags & ~Shiro::PDNOWKICK);
+            q->piecepool = qrspool_get(false);
             q->tetromino_only = 1;
             q->pentomino_only = 0;
             cs->request_fps(Shiro::RefreshRates::g3);
@@ -2890,6 +2935,8 @@ int qs_update_pracdata(CoreState *cs)
     if(md->numopts == MENU_PRACTICE_NUMOPTS && md->menu[static_cast<size_t>(md->numopts) - 1].type == Shiro::ElementType::MENU_TEXTINPUT)
     {
         std::string seqStr = ((Shiro::TextOptionData*)(md->menu[static_cast<size_t>(md->numopts) - 1].data))->text;
+        // each character adds at most two elements (a piece and the implicit count before it), plus a final count
+        piece_seq.resize(2 * seqStr.size() + 1);
         for(i = 0; i < seqStr.size(); i++)
         {
             c = seqStr[i];
@@ -3260,23 +3307,14 @@ int qs_update_pracdata(CoreState *cs)
     }
 
 end_sequence_proc:
-    for(i = 0; i < num; i++)
-        d->usr_sequence[i] = piece_seq[i];
-
-    d->usr_seq_len = num;
-    d->usr_seq_expand_len = 0;
+    piece_seq.resize(num);
+    d->usr_sequence.compile(piece_seq);
 
     /**/
 
     qrsfield_set_w(cs->p1game->field, q->field_w);
     qrsfield_set_w(&q->pracdata->usr_field, q->field_w);
 
-    for(i = 0; i < d->usr_field_undo.size(); i++)
-        qrsfield_set_w(&q->pracdata->usr_field_undo[i], q->field_w);
-
-    for(i = 0; i < d->usr_field_redo.size(); i++)
-        qrsfield_set_w(&q->pracdata->usr_field_redo[i], q->field_w);
-
     d->field_selection = 0;
 
     // process randomizer seed entry...
@@ -3285,7 +3323,7 @@ end_sequence_proc:
 
     q->previews.clear();
 
-    if(q->pracdata->usr_seq_len)
+    if(!q->pracdata->usr_sequence.empty())
     {
         for (size_t i = 0; i < 4; i++) {
             int elem = qs_get_usrseq_elem(d, i);
@@ -3327,216 +3365,9 @@ end_sequence_proc:
     return 0;
 }
 
-// TODO: clean this function up, especially the parser + expander, and use more established terminology
 int qs_get_usrseq_elem(pracdata *d, std::size_t index)
 {
-    int *seq = d->usr_sequence;
-    int expand[4000];
-    std::size_t expand_count = 0;
-
-    std::size_t rpt_start = 0;
-    std::size_t rpt_end = 0;
-    std::size_t rpt_len = 0;
-    std::size_t rpt_count = 0;
-    bool rpt = false;
-    std::size_t inf_rpt_len = 0;
-    std::size_t inf_start = 0;
-
-    int inf = 0;
-
-    std::size_t i = 0;
-    std::size_t j = 0;
-    std::size_t k = 0;
-    int val = 0;
-    int complex = 0;
-
-    if(d->usr_seq_expand_len)
-    {
-        for(i = 0; i < d->usr_seq_expand_len; i++)
-        {
-            if(d->usr_seq_expand[i] & SEQUENCE_REPEAT_INF)
-            {
-                inf = 1;
-                rpt_start = i;
-                inf_rpt_len = d->usr_seq_expand_len - rpt_start;
-            }
-        }
-
-        if(inf)
-        {
-            if(index < rpt_start)
-            {
-                val = d->usr_seq_expand[index] & 0b11111;
-            }
-            else
-            {
-                if(inf_rpt_len > 1)
-                    index = (index - rpt_start) % inf_rpt_len;
-                else
-                    index = 0;
-
-                val = d->usr_seq_expand[rpt_start + index] & 0b11111;
-            }
-        }
-        else
-        {
-            if(index > d->usr_seq_expand_len - 1)
-                val = USRSEQ_ELEM_OOB;
-            else
-                val = d->usr_seq_expand[index] & 0b11111;
-        }
-
-        return val;
-    }
-
-    if(!d->usr_seq_len)
-    {
-        d->usr_seq_expand_len = 0;
-        return USRSEQ_ELEM_OOB;
-    }
-
-    for(i = 0; i < index && i < d->usr_seq_len; i++)
-    {
-        if(!IS_QRS_PIECE(seq[i]))
-            complex = 1;
-    }
-
-    if(!complex && index < d->usr_seq_len)
-    {
-        if(IS_QRS_PIECE(seq[index]))
-            return seq[index];
-    }
-
-    for(i = 0;; i++)
-    {
-        if(i >= d->usr_seq_len || expand_count > 3500)
-        {
-            // 3500 is an arbitrary limit to prevent taking up too much memory for little benefit
-            break;
-        }
-
-        val = seq[i];
-        if(rpt)
-        {
-            /* rpt = true implies we encountered the beginning of a grouped subsequence, where groups are assumed
-            to have a rep count specified at the end */
-            if(val & SEQUENCE_REPEAT_END || i == d->usr_seq_len - 1)
-            {
-                rpt = false;
-                rpt_end = i;
-                rpt_len = rpt_end - rpt_start + 1; // length of grouped subsequence
-                i++;                               // next element of the sequence is either a repetition count or beyond the end of the sequence
-
-                if(i != d->usr_seq_len && seq[i] == SEQUENCE_REPEAT_INF)
-                {
-                    // ^^ bound check must come first to prevent seq[i] from creating UB
-                    inf = 1;
-                    inf_rpt_len = rpt_len;
-                    inf_start = rpt_start;
-                    expand_count += rpt_len;
-                    for(k = 0; k < rpt_len; k++)
-                    {
-                        /* seq[blah] & 0b11111 zeroes other flags on the piece;
-                        first repeated element gets repeat_inf flag;
-                        expanded sequence is cut off after the infinitely repeating group and this expansion loop ends */
-
-                        expand[expand_count - rpt_len + k] = (seq[rpt_start + k] & 0b11111) | (!k ? SEQUENCE_REPEAT_INF : 0);
-                    }
-
-                    break;
-                }
-                else
-                {
-                    // dealing with finite repetition or open-ended grouped subsequence
-
-                    if(i == d->usr_seq_len)
-                        rpt_count = 1;
-                    // ^^ force open-ended group to 1 repetition (same as if there was no grouping)
-
-                    else
-                    {
-                        if(seq[i] > USRSEQ_RPTCOUNT_MAX) // last-minute bounding of repetition count to something reasonable
-                            rpt_count = USRSEQ_RPTCOUNT_MAX;
-                        else
-                            rpt_count = seq[i];
-                    }
-
-                    for(k = 0; k < rpt_count; k++)
-                    { // expand entire repetition to sequence of pieces with no special flags
-                        for(j = 0; j < rpt_len; j++)
-                        {
-                            expand[expand_count + k * rpt_len + j] = seq[rpt_start + j] & 0b11111;
-                        }
-                    }
-
-                    expand_count += rpt_count * rpt_len;
-                    rpt = false; // we are done with this grouped subsequence
-                }
-            }
-        }
-        else
-        {
-            if(val & SEQUENCE_REPEAT_START)
-            {
-                rpt_start = i;
-                rpt = true;
-                if(val & SEQUENCE_REPEAT_END || i == d->usr_seq_len - 1)
-                {
-                    i--;      // hacky way for the loop to go into the if(rpt) branch and handle these edge cases
-                    continue; // the i-- ensures the loop reads the additional flags on this element/doesn't go OOB
-                }
-            }
-            else
-            { // no expansion to be done
-                expand_count++;
-                expand[expand_count - 1] = seq[i] & 0b11111;
-            }
-        }
-    }
-
-    // end of expansion loop
-
-    if(inf)
-    {
-        if(index < inf_start)
-        { // index is of the piece we want to return to the function caller
-            val = expand[index] & 0b11111;
-        }
-        else
-        {
-            if(inf_rpt_len > 1)
-            {
-                // collapse an arbitrarily large index value to a relative one that fits in the array bounds
-                index = (index - inf_start) % inf_rpt_len;
-            }
-            else
-                index = 0;
-
-            val = expand[inf_start + index] & 0b11111;
-        }
-    }
-    else
-    {
-        if(index < expand_count)
-            val = expand[index] & 0b11111;
-        else
-            val = USRSEQ_ELEM_OOB;
-    }
-
-//     std::cerr << "Expanded sequence:" << std::endl;
-//     for (i = 0; i < expand_count; i++) {
-//         std::cerr << " " << expand[i];
-//
-//     }
-//     std::cerr << std::endl;
-
-    // updating the pracdata's expanded sequence field so we don't have to waste time expanding it later unless it changes
-    for(i = 0; i < expand_count; i++)
-        d->usr_seq_expand[i] = expand[i];
-
-    d->usr_seq_expand_len = expand_count;
-
-    return val;
+    return d->usr_sequence.at(index);
 }
 
 // return value: 0 success, -1 invalid argument(s), 1 no next piece to deal to the player
@@ -3545,7 +3376,6 @@ int qs_initnext(game_t *g, qrs_player *p, unsigned int flags)
     if(!g || !p)
         return -1;
 
-    CoreState *cs = g->origin;
     qrsdata *q = (qrsdata *)(g->data);
     struct randomizer *qrand = q->randomizer;
 
@@ -3568,7 +3398,7 @@ int qs_initnext(game_t *g, qrs_player *p, unsigned int flags)
         // we don't want the game to terminate while the player is controlling a piece
         // edge case where this is relevant: player uses hold with no held piece, at last piece in user seq
 
-        if(q->pracdata && q->pracdata->usr_seq_len)
+        if(q->pracdata && !q->pracdata->usr_sequence.empty())
         {
             if(qs_get_usrseq_elem(q->pracdata, static_cast<size_t>(q->pracdata->hist_index) + 1) == USRSEQ_ELEM_OOB)
             {
@@ -3600,7 +3430,7 @@ int qs_initnext(game_t *g, qrs_player *p, unsigned int flags)
         }
     }
 
-    if(q->pracdata && q->pracdata->usr_seq_len)
+    if(q->pracdata && !q->pracdata->usr_sequence.empty())
     {
         q->pracdata->hist_index++;
         rc = qs_get_usrseq_elem(q->pracdata, q->pracdata->hist_index);
@@ -3663,7 +3493,8 @@ int qs_initnext(game_t *g, qrs_player *p, unsigned int flags)
             /*Shiro::Sfx* sfx = cs->assets->pieces[ts % 7];
             sfx->play(cs->settings);
             */
-            Shiro::SfxAsset::get(cs->assetMgr, "pieces", ts % 7).play(cs->settings);
+            if(g->sink)
+                g->sink->playSfx("pieces", ts % 7);
         }
     }
 
@@ -3705,5 +3536,9 @@ int qs_initnext(game_t *g, qrs_player *p, unsigned int flags)
 
     q->p1counters->lock = 0;
 
+    // a hold swaps pieces mid-placement, so only freshly dealt pieces get a rewind point
+    if(q->pracdata && q->pracdata->rewind && !(flags & INITNEXT_DURING_ACTIVE_PLAY))
+        q->pracdata->rewind->record(*g);
+
     return 0;
 }
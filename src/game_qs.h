@@ -10,6 +10,8 @@
 
 #define QS_LEVEL_CREDITS 9001
 
+#define PENTOMINO_C_REVISION_STRING "rev 1.3"
+
 #define MODE_PENTOMINO 0
 
 #define NIGHTMARE_MODE 0x0001
@@ -124,6 +126,14 @@ const char *get_grade_name(int grade);
 const char *get_internal_grade_name(int index);
 int internal_to_displayed_grade(int internal_grade);
 
+// starts the track for the current level if it isn't already playing
+void qs_sync_music(game_t *g);
+
+// p1->speeds points into one of the static speed curves; these number its entries so the pointer can be saved
+// (-1/NULL for anything else, like practice timings)
+int qs_speeds_index(const QRS_Timings *speeds);
+QRS_Timings *qs_speeds_from_index(int index);
+
 game_t *qs_game_create(CoreState *cs, int level, unsigned int flags, int replay_id);
 int qs_game_init(game_t *g);
 int qs_game_pracinit(game_t *g, int val);
@@ -54,16 +54,20 @@ int gfx_drawmenu(game_t *g)
     if(d->is_paged)
     {
         std::stringstream ss;
-        ss << "PAGE " << d->page + 1 << "/" << ((d->numopts - 1) / d->page_length) + 1;
+        ss << "PAGE " << d->page + 1 << "/" << (d->load_page ? d->page_count : ((d->numopts - 1) / d->page_length) + 1);
         page_str = ss.str();
         fmt = text_fmt_create(DRAWTEXT_ALIGN_RIGHT, RGBA_DEFAULT, RGBA_OUTLINE_DEFAULT);
 
         gfx_drawtext(cs, page_str, d->page_text_x, d->page_text_y, monofont_square, &fmt);
 
-        initial_opt = d->page * d->page_length;
-        final_opt = d->page * d->page_length + d->page_length - 1;
-        if(final_opt > d->numopts - 1)
-            final_opt = d->numopts - 1;
+        // menus that load their pages only hold the page shown
+        if(!d->load_page)
+        {
+            initial_opt = d->page * d->page_length;
+            final_opt = d->page * d->page_length + d->page_length - 1;
+            if(final_opt > d->numopts - 1)
+                final_opt = d->numopts - 1;
+        }
     }
 
     if(!d->menu.size())
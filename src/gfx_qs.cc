@@ -197,9 +197,9 @@ int gfx_drawqs(game_t *g)
             if(q->pracdata->field_selection)
                 gfx_drawfield_selection(g, q->pracdata);
 
-            if(q->pracdata->usr_field_undo.size())
+            if(q->pracdata->usr_field_history.undoSize())
             {
-                undo_len = strtools::format("%d", q->pracdata->usr_field_undo.size());
+                undo_len = strtools::format("%d", q->pracdata->usr_field_history.undoSize());
 
                 gfx_drawtext(cs, undo, QRS_FIELD_X + 32, QRS_FIELD_Y + 23 * 16, monofont_square, NULL);
                 gfx_drawtext(cs, undo_len, QRS_FIELD_X + 32, QRS_FIELD_Y + 24 * 16, monofont_square, NULL);
@@ -212,9 +212,9 @@ int gfx_drawqs(game_t *g)
                 SDL_RenderCopy(cs->screen.renderer, font, &src, &dest);
             }
 
-            if(q->pracdata->usr_field_redo.size())
+            if(q->pracdata->usr_field_history.redoSize())
             {
-                redo_len = strtools::format("%d", q->pracdata->usr_field_redo.size());
+                redo_len = strtools::format("%d", q->pracdata->usr_field_history.redoSize());
 
                 gfx_drawtext(cs, redo, QRS_FIELD_X + 9 * 16, QRS_FIELD_Y + 23 * 16, monofont_square, NULL);
                 gfx_drawtext(cs, redo_len, QRS_FIELD_X + 13 * 16 - 16 * (int)redo_len.size(), QRS_FIELD_Y + 24 * 16, monofont_square, NULL);
@@ -227,7 +227,7 @@ int gfx_drawqs(game_t *g)
                 SDL_RenderCopy(cs->screen.renderer, font, &src, &dest);
             }
 
-            if(q->pracdata->usr_seq_len)
+            if(!q->pracdata->usr_sequence.empty())
             {
                 if(qs_get_usrseq_elem(q->pracdata, 0) == QRS_I4 || qs_get_usrseq_elem(q->pracdata, 0) == QRS_I)
                     drawpiece_next1_flags = DRAWPIECE_PREVIEW | DRAWPIECE_IPREVIEW;
@@ -396,6 +396,10 @@ int gfx_drawqs(game_t *g)
                     secTimeFmt.rgba = RGBA_DEFAULT;
                     textX -= 7*16 + 8;
 
+                    // against the player's best split, when there is one
+                    if(q->best_section_times[sec] != -1)
+                        secTimeFmt.rgba = q->section_times[sec] < q->best_section_times[sec] ? 0x20FF20FF : 0xFF7070FF;
+
                     if(minutes == 0)
                     {
                         secTimeStr = strtools::format("   %02d:%02d", seconds, centiseconds);
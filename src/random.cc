@@ -1,8 +1,11 @@
 #include "random.h"
 #include "QRS0.h"
+#include <array>
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <cassert>
 
@@ -68,18 +71,6 @@ static long double pento_drought_coeffs[25] =
 };
 // clang-format on
 
-uint32_t g1_seed = 0;
-uint32_t g1_bkp_seed = 0;
-
-uint32_t g2_seed = 0;
-uint32_t g2_bkp_seed = 0;
-
-uint32_t g3_seed = 0;
-uint32_t g3_bkp_seed = 0;
-
-uint32_t pento_seed = 0;
-uint32_t pento_bkp_seed = 0;
-
 // piece_id g3_bag[35];
 // piece_id *sakura_seq; TODO
 
@@ -114,22 +105,16 @@ piece_id ars_to_qrs_id(piece_id t)
     return t + 18;
 }
 
-void g123_seeds_init()
+/* Starting seed for a newly created randomizer. The entropy counter is the
+   only state shared between randomizers; it's atomic so games can be created
+   from several threads at once, and each one gets a distinct starting seed. */
+static uint32_t randomizer_fresh_seed(uint32_t range)
 {
-    unsigned s = (unsigned)time(0);
-    srand(s);
-
-    s = rand();
-    g1_seed = g2_rand((s >> 12) % 23890);
-
-    s = rand();
-    g2_seed = g2_rand((s << 5) % 17622);
-
-    s = rand();
-    g3_seed = g2_rand((s << 8) % 8997);
+    static std::atomic<uint32_t> entropy{ (uint32_t)time(0) };
+    uint32_t s = entropy.fetch_add(0x9e3779b9u, std::memory_order_relaxed);
 
-    s = rand();
-    pento_seed = g2_rand((s << 4) % 11456);
+    s = g2_rand(s) ^ (s >> 16);
+    return g2_rand(s % range);
 }
 
 // int seeds_are_close(uint32_t s1, uint32_t s2, unsigned int max_gap)
@@ -175,7 +160,7 @@ struct randomizer *g1_randomizer_create(uint32_t flags)
     struct histrand_data *d = NULL;
 
     r->num_pieces = 7;
-    r->seedp = &g1_seed;
+    r->seed = randomizer_fresh_seed(23890);
     r->type = HISTRAND;
 
     r->init = g1_randomizer_init;
@@ -201,6 +186,14 @@ struct randomizer *g1_randomizer_create(uint32_t flags)
     d->drought_protection_coefficients = NULL;
     d->drought_times = NULL;
 
+    d->history_counts = NULL;
+    d->scratch_weights = NULL;
+    d->drought_multipliers = NULL;
+
+    d->difficulty_multipliers_for = -1.0;
+    d->toptier_difficulty_multiplier = 1.0;
+    d->hightier_difficulty_multiplier = 1.0;
+
     return r;
 }
 
@@ -211,7 +204,7 @@ struct randomizer *g2_randomizer_create(uint32_t flags)
     struct histrand_data *d = NULL;
 
     r->num_pieces = 7;
-    r->seedp = &g2_seed;
+    r->seed = randomizer_fresh_seed(17622);
     r->type = HISTRAND;
 
     r->init = g2_randomizer_init;
@@ -237,6 +230,14 @@ struct randomizer *g2_randomizer_create(uint32_t flags)
     d->drought_protection_coefficients = NULL;
     d->drought_times = NULL;
 
+    d->history_counts = NULL;
+    d->scratch_weights = NULL;
+    d->drought_multipliers = NULL;
+
+    d->difficulty_multipliers_for = -1.0;
+    d->toptier_difficulty_multiplier = 1.0;
+    d->hightier_difficulty_multiplier = 1.0;
+
     return r;
 }
 
@@ -248,7 +249,7 @@ struct randomizer *g3_randomizer_create(uint32_t flags)
     int i = 0;
 
     r->num_pieces = 7;
-    r->seedp = &g3_seed;
+    r->seed = randomizer_fresh_seed(8997);
     r->type = G3RAND;
 
     r->init = g3_randomizer_init;
@@ -279,7 +280,7 @@ struct randomizer *pento_randomizer_create(uint32_t flags)
     unsigned int i = 0;
 
     r->num_pieces = 25;
-    r->seedp = &pento_seed;
+    r->seed = randomizer_fresh_seed(11456);
     r->type = HISTRAND;
 
     r->init = pento_randomizer_init;
@@ -310,11 +311,29 @@ struct randomizer *pento_randomizer_create(uint32_t flags)
     d->drought_times = (unsigned int *)malloc(r->num_pieces * sizeof(unsigned int));
     assert(d->drought_times != nullptr);
 
+    d->history_counts = (unsigned int *)malloc(r->num_pieces * sizeof(unsigned int));
+    assert(d->history_counts != nullptr);
+    d->scratch_weights = (double *)malloc(r->num_pieces * sizeof(double));
+    assert(d->scratch_weights != nullptr);
+    d->drought_multipliers = (double *)malloc(r->num_pieces * HISTRAND_DROUGHT_TABLE_LEN * sizeof(double));
+    assert(d->drought_multipliers != nullptr);
+
+    d->difficulty_multipliers_for = -1.0;
+    d->toptier_difficulty_multiplier = 1.0;
+    d->hightier_difficulty_multiplier = 1.0;
+
     for(i = 0; i < r->num_pieces; i++)
     {
         d->piece_weights[i] = double(pento_piece_weights[i]);
         d->drought_protection_coefficients[i] = double(pento_drought_coeffs[i]);
         d->drought_times[i] = 0u;
+        d->history_counts[i] = 0u;
+
+        // same expression histrand_get_next used to evaluate every pull, so the results are bit-identical
+        for(unsigned int t = 0; t < HISTRAND_DROUGHT_TABLE_LEN; t++)
+        {
+            d->drought_multipliers[i * HISTRAND_DROUGHT_TABLE_LEN + t] = pow(d->drought_protection_coefficients[i], (double)(t) / QRS_DROUGHT_BASELINE);
+        }
     }
 
     return r;
@@ -340,6 +359,12 @@ void randomizer_destroy(struct randomizer *r)
                 free(d->drought_protection_coefficients);
             if(d->drought_times)
                 free(d->drought_times);
+            if(d->history_counts)
+                free(d->history_counts);
+            if(d->scratch_weights)
+                free(d->scratch_weights);
+            if(d->drought_multipliers)
+                free(d->drought_multipliers);
 
             free(r->data);
             break;
@@ -357,6 +382,191 @@ void randomizer_destroy(struct randomizer *r)
     free(r);
 }
 
+static void *dup_array(const void *src, size_t size)
+{
+    if(!src)
+        return NULL;
+
+    void *dst = malloc(size);
+    assert(dst != nullptr);
+    memcpy(dst, src, size);
+
+    return dst;
+}
+
+struct randomizer *randomizer_clone(struct randomizer *r)
+{
+    if(!r)
+        return NULL;
+
+    struct randomizer *cpy = (struct randomizer *)malloc(sizeof(struct randomizer));
+    assert(cpy != nullptr);
+    *cpy = *r;
+
+    switch(r->type)
+    {
+        case HISTRAND:
+        {
+            struct histrand_data *d = (struct histrand_data *)r->data;
+            struct histrand_data *cd = (struct histrand_data *)dup_array(d, sizeof(struct histrand_data));
+
+            cd->history = (piece_id *)dup_array(d->history, d->hist_len * sizeof(piece_id));
+            cd->piece_weights = (double *)dup_array(d->piece_weights, r->num_pieces * sizeof(double));
+            cd->drought_protection_coefficients = (double *)dup_array(d->drought_protection_coefficients, r->num_pieces * sizeof(double));
+            cd->drought_times = (unsigned int *)dup_array(d->drought_times, r->num_pieces * sizeof(unsigned int));
+            cd->history_counts = (unsigned int *)dup_array(d->history_counts, r->num_pieces * sizeof(unsigned int));
+            cd->scratch_weights = (double *)dup_array(d->scratch_weights, r->num_pieces * sizeof(double));
+            cd->drought_multipliers = (double *)dup_array(d->drought_multipliers, r->num_pieces * HISTRAND_DROUGHT_TABLE_LEN * sizeof(double));
+
+            cpy->data = cd;
+            break;
+        }
+
+        case G3RAND:
+            cpy->data = dup_array(r->data, sizeof(struct g3rand_data));
+            break;
+
+        default:
+            break;
+    }
+
+    return cpy;
+}
+
+void randomizer_copy_state(struct randomizer *dst, struct randomizer *src)
+{
+    assert(dst->type == src->type && dst->num_pieces == src->num_pieces);
+
+    dst->seed = src->seed;
+
+    switch(src->type)
+    {
+        case HISTRAND:
+        {
+            struct histrand_data *dd = (struct histrand_data *)dst->data;
+            struct histrand_data *sd = (struct histrand_data *)src->data;
+
+            assert(dd->hist_len == sd->hist_len);
+
+            if(sd->history)
+                memcpy(dd->history, sd->history, sd->hist_len * sizeof(piece_id));
+            if(sd->drought_times)
+                memcpy(dd->drought_times, sd->drought_times, src->num_pieces * sizeof(unsigned int));
+            if(sd->history_counts)
+                memcpy(dd->history_counts, sd->history_counts, src->num_pieces * sizeof(unsigned int));
+
+            dd->difficulty = sd->difficulty;
+            break;
+        }
+
+        case G3RAND:
+            memcpy(dst->data, src->data, sizeof(struct g3rand_data));
+            break;
+
+        default:
+            break;
+    }
+}
+
+size_t randomizer_state_size(struct randomizer *r)
+{
+    size_t size = sizeof(uint32_t);
+
+    switch(r->type)
+    {
+        case HISTRAND:
+        {
+            struct histrand_data *d = (struct histrand_data *)r->data;
+
+            size += sizeof(double) + d->hist_len * sizeof(piece_id);
+            if(d->drought_times)
+                size += r->num_pieces * sizeof(unsigned int);
+            if(d->history_counts)
+                size += r->num_pieces * sizeof(unsigned int);
+            break;
+        }
+
+        case G3RAND:
+            size += sizeof(struct g3rand_data);
+            break;
+
+        default:
+            break;
+    }
+
+    return size;
+}
+
+void randomizer_save_state(struct randomizer *r, uint8_t *out)
+{
+    memcpy(out, &r->seed, sizeof(uint32_t));
+    out += sizeof(uint32_t);
+
+    switch(r->type)
+    {
+        case HISTRAND:
+        {
+            struct histrand_data *d = (struct histrand_data *)r->data;
+
+            memcpy(out, &d->difficulty, sizeof(double));
+            out += sizeof(double);
+            if(d->history)
+                memcpy(out, d->history, d->hist_len * sizeof(piece_id));
+            out += d->hist_len * sizeof(piece_id);
+            if(d->drought_times)
+            {
+                memcpy(out, d->drought_times, r->num_pieces * sizeof(unsigned int));
+                out += r->num_pieces * sizeof(unsigned int);
+            }
+            if(d->history_counts)
+                memcpy(out, d->history_counts, r->num_pieces * sizeof(unsigned int));
+            break;
+        }
+
+        case G3RAND:
+            memcpy(out, r->data, sizeof(struct g3rand_data));
+            break;
+
+        default:
+            break;
+    }
+}
+
+void randomizer_load_state(struct randomizer *r, const uint8_t *in)
+{
+    memcpy(&r->seed, in, sizeof(uint32_t));
+    in += sizeof(uint32_t);
+
+    switch(r->type)
+    {
+        case HISTRAND:
+        {
+            struct histrand_data *d = (struct histrand_data *)r->data;
+
+            memcpy(&d->difficulty, in, sizeof(double));
+            in += sizeof(double);
+            if(d->history)
+                memcpy(d->history, in, d->hist_len * sizeof(piece_id));
+            in += d->hist_len * sizeof(piece_id);
+            if(d->drought_times)
+            {
+                memcpy(d->drought_times, in, r->num_pieces * sizeof(unsigned int));
+                in += r->num_pieces * sizeof(unsigned int);
+            }
+            if(d->history_counts)
+                memcpy(d->history_counts, in, r->num_pieces * sizeof(unsigned int));
+            break;
+        }
+
+        case G3RAND:
+            memcpy(r->data, in, sizeof(struct g3rand_data));
+            break;
+
+        default:
+            break;
+    }
+}
+
 // ------ //
 
 int g1_randomizer_init(struct randomizer *r, uint32_t *seed)
@@ -366,15 +576,13 @@ int g1_randomizer_init(struct randomizer *r, uint32_t *seed)
     int num_generated = 0;
 
     if(seed)
-    {
-        g1_bkp_seed = g1_seed;
-        g1_seed = *seed;
-    }
+        r->seed = *seed;
 
     d->history[0] = ARS_Z;
     d->history[1] = ARS_Z;
     d->history[2] = ARS_Z;
-    d->history[3] = g123_get_init_piece(&g1_seed);
+    d->history[3] = g123_get_init_piece(&r->seed);
+    histrand_count_history(r);
     num_generated = 1;
 
     for(i = 0; i < 3; i++) // move init piece to history[0] (first preview/next piece) and fill in 3 pieces ahead
@@ -393,15 +601,13 @@ int g2_randomizer_init(struct randomizer *r, uint32_t *seed)
     int num_generated = 0;
 
     if(seed)
-    {
-        g2_bkp_seed = g2_seed;
-        g2_seed = *seed;
-    }
+        r->seed = *seed;
 
     d->history[0] = ARS_S;
     d->history[1] = ARS_S;
     d->history[2] = ARS_Z;
-    d->history[3] = g123_get_init_piece(&g2_seed);
+    d->history[3] = g123_get_init_piece(&r->seed);
+    histrand_count_history(r);
     num_generated = 1;
 
     for(i = 0; i < 3; i++)
@@ -422,10 +628,7 @@ int g3_randomizer_init(struct randomizer *r, uint32_t *seed)
     int num_generated = 0;
 
     if(seed)
-    {
-        g3_bkp_seed = g3_seed;
-        g3_seed = *seed;
-    }
+        r->seed = *seed;
 
     for(i = 0; i < 35; i++)
         d->bag[i] = i / 5;
@@ -433,7 +636,7 @@ int g3_randomizer_init(struct randomizer *r, uint32_t *seed)
     d->history[0] = ARS_S;
     d->history[1] = ARS_S;
     d->history[2] = ARS_Z;
-    d->history[3] = g123_get_init_piece(r->seedp);
+    d->history[3] = g123_get_init_piece(&r->seed);
     num_generated = 1;
 
     for(i = 0; i < 3; i++)
@@ -455,14 +658,11 @@ int pento_randomizer_init(struct randomizer *r, uint32_t *seed)
     int num_generated = 0;
 
     if(seed)
-    {
-        pento_bkp_seed = pento_seed;
-        pento_seed = *seed;
-    }
+        r->seed = *seed;
 
     for(unsigned j = 0; j < r->num_pieces; j++)
     {
-        d->drought_times[j] = pento_read_rand(r->seedp) % 30;
+        d->drought_times[j] = pento_read_rand(&r->seed) % 30;
     }
 
     d->history[0] = QRS_Fb;
@@ -471,7 +671,7 @@ int pento_randomizer_init(struct randomizer *r, uint32_t *seed)
     d->history[3] = QRS_S;
     d->history[4] = QRS_Z;
 
-    t = pento_read_rand(r->seedp) % 5;
+    t = pento_read_rand(&r->seed) % 5;
 
     switch(t)
     {
@@ -495,6 +695,7 @@ int pento_randomizer_init(struct randomizer *r, uint32_t *seed)
             break;
     }
 
+    histrand_count_history(r);
     num_generated = 1;
 
     for(i = 0; i < 5; i++)
@@ -541,6 +742,24 @@ bool in_history(piece_id *history, unsigned int hist_len, piece_id t)
     return false;
 }
 
+void histrand_count_history(struct randomizer *r)
+{
+    struct histrand_data *d = (struct histrand_data *)r->data;
+    unsigned int i = 0;
+
+    if(!d->history_counts)
+        return;
+
+    for(i = 0; i < r->num_pieces; i++)
+        d->history_counts[i] = 0;
+
+    for(i = 0; i < d->hist_len; i++)
+    {
+        if(d->history[i] < r->num_pieces)
+            d->history_counts[d->history[i]]++;
+    }
+}
+
 piece_id histrand_pull(struct randomizer *r)
 {
     struct histrand_data *d = (struct histrand_data *)r->data;
@@ -550,6 +769,14 @@ piece_id histrand_pull(struct randomizer *r)
 
     history_push(d->history, d->hist_len, t);
 
+    if(d->history_counts)
+    { // one piece left the history and one entered it
+        if(result < r->num_pieces)
+            d->history_counts[result]--;
+        if(t < r->num_pieces)
+            d->history_counts[t]++;
+    }
+
     if(d->drought_times)
     { // update drought times if we are using them
         for(i = 0; i < r->num_pieces; i++)
@@ -575,10 +802,41 @@ piece_id g3rand_pull(struct randomizer *r)
     return piece;
 }
 
+// weight multiplier for a piece that has been in drought for drought_time pieces
+static double histrand_drought_multiplier(struct histrand_data *d, unsigned int piece)
+{
+    unsigned int drought_time = d->drought_times[piece];
+
+    if(drought_time < HISTRAND_DROUGHT_TABLE_LEN)
+        return d->drought_multipliers[piece * HISTRAND_DROUGHT_TABLE_LEN + drought_time];
+
+    return pow(d->drought_protection_coefficients[piece], (double)(drought_time) / QRS_DROUGHT_BASELINE);
+}
+
+// extra multiplier once a drought passes a tier's soft limit: 1.3^(drought_time - softlimit + 1)
+static double histrand_softlimit_multiplier(unsigned int drought_time, int softlimit)
+{
+    // built on first use; function-local statics are initialized thread-safely
+    static const std::array<double, HISTRAND_DROUGHT_TABLE_LEN> table = []()
+    {
+        std::array<double, HISTRAND_DROUGHT_TABLE_LEN> powers;
+        for(unsigned int k = 0; k < HISTRAND_DROUGHT_TABLE_LEN; k++)
+            powers[k] = pow(1.3, (double)(k));
+        return powers;
+    }();
+
+    unsigned int k = drought_time - softlimit + 1;
+
+    if(k < HISTRAND_DROUGHT_TABLE_LEN)
+        return table[k];
+
+    return pow(1.3, (double)drought_time - softlimit + 1.0);
+}
+
 piece_id histrand_get_next(struct randomizer *r)
 {
     struct histrand_data *d = (struct histrand_data *)r->data;
-    uint32_t *seedp = r->seedp;
+    uint32_t *seedp = &r->seed;
     unsigned int i = 0;
     unsigned int j = 0;
     bool in_hist = false;
@@ -587,11 +845,6 @@ piece_id histrand_get_next(struct randomizer *r)
     long double p = 0.0;
     double old_sum = 0.0;
     double sum = 0.0;
-    unsigned int *histogram = (unsigned int *)malloc(r->num_pieces * sizeof(unsigned int));
-    double *temp_weights = (double *)malloc(r->num_pieces * sizeof(double));
-
-    if(!seedp)
-        seedp = &g2_seed;
 
     if(!d->piece_weights) // if we are using rerolls and not weighted calculation
     {
@@ -612,61 +865,62 @@ piece_id histrand_get_next(struct randomizer *r)
             t = g123_read_rand(seedp) % 7;
         }
 
-        free(temp_weights);
-        free(histogram);
-
         return t;
     }
 
     else
     {
+        double *temp_weights = d->scratch_weights;
+        unsigned int *history_counts = d->history_counts;
+
         // starts at 1 and counts up, bad pieces' weights are divided by this
         int below_high_threshold = 1;
 
+        if(d->difficulty != d->difficulty_multipliers_for)
+        {
+            d->toptier_difficulty_multiplier = pow(1.1, (30.0 - d->difficulty) / 3);
+            d->hightier_difficulty_multiplier = pow(1.1, (30.0 - d->difficulty) / 6);
+            d->difficulty_multipliers_for = d->difficulty;
+        }
+
         for(i = 0; i < r->num_pieces; i++)
         {
-            temp_weights[i] = d->piece_weights[i];
-            // histogram values are all offset by one from how many times the piece is actually in the history
-            histogram[i] = 1;
+            if(d->piece_weights[i] < QRS_WEIGHT_HIGHTIER_THRESHOLD)
+                below_high_threshold += history_counts[i];
+        }
 
-            for(j = 0; j < d->hist_len; j++)
-            {
-                if(d->history[j] == i)
-                {
-                    histogram[i]++;
-                    if(d->piece_weights[i] < QRS_WEIGHT_HIGHTIER_THRESHOLD)
-                    {
-                        below_high_threshold++;
-                    }
-                }
-            }
+        for(i = 0; i < r->num_pieces; i++)
+        {
+            // histogram values are all offset by one from how many times the piece is actually in the history
+            double histogram = (double)(history_counts[i] + 1);
 
-            temp_weights[i] /= (double)histogram[i] * histogram[i]; // OLD: * (i < 18 ? pieces[i] : 1)
+            temp_weights[i] = d->piece_weights[i];
+            temp_weights[i] /= histogram * histogram; // OLD: * (i < 18 ? pieces[i] : 1)
             if(d->drought_protection_coefficients && d->drought_times)
             {
                 // multiply by coefficient^(t/BASELINE)
                 // e.g. for coeff 2 and drought time BASELINE, weight *= 2
-                temp_weights[i] *= pow(d->drought_protection_coefficients[i], (double)(d->drought_times[i]) / QRS_DROUGHT_BASELINE);
+                temp_weights[i] *= histrand_drought_multiplier(d, i);
 
                 if((d->piece_weights[i] >= QRS_WEIGHT_HIGHTIER_THRESHOLD) && (QRS_DROUGHT_HIGHTIER_SOFTLIMIT >= 0))
                 {
                     if(d->drought_times[i] >= QRS_DROUGHT_HIGHTIER_SOFTLIMIT)
                     {
-                        temp_weights[i] *= pow(1.3, (double)d->drought_times[i] - QRS_DROUGHT_HIGHTIER_SOFTLIMIT + 1.0);
+                        temp_weights[i] *= histrand_softlimit_multiplier(d->drought_times[i], QRS_DROUGHT_HIGHTIER_SOFTLIMIT);
                     }
                 }
                 else if((d->difficulty >= 30.0) && (d->piece_weights[i] >= QRS_WEIGHT_MIDTIER_THRESHOLD) && (QRS_DROUGHT_MIDTIER_SOFTLIMIT >= 0))
                 {
                     if(d->drought_times[i] >= QRS_DROUGHT_MIDTIER_SOFTLIMIT)
                     {
-                        temp_weights[i] *= pow(1.3, (double)d->drought_times[i] - QRS_DROUGHT_MIDTIER_SOFTLIMIT + 1.0);
+                        temp_weights[i] *= histrand_softlimit_multiplier(d->drought_times[i], QRS_DROUGHT_MIDTIER_SOFTLIMIT);
                     }
                 }
                 else if((d->difficulty >= 30.0) && (QRS_DROUGHT_LOWTIER_SOFTLIMIT >= 0))
                 {
                     if(int(d->drought_times[i]) >= QRS_DROUGHT_LOWTIER_SOFTLIMIT)
                     {
-                        temp_weights[i] *= pow(1.3, (double)d->drought_times[i] - QRS_DROUGHT_LOWTIER_SOFTLIMIT + 1.0);
+                        temp_weights[i] *= histrand_softlimit_multiplier(d->drought_times[i], QRS_DROUGHT_LOWTIER_SOFTLIMIT);
                     }
                 }
             }
@@ -681,12 +935,12 @@ piece_id histrand_get_next(struct randomizer *r)
 
             if((d->difficulty < 30.0) && (d->piece_weights[i] >= QRS_WEIGHT_TOPTIER_THRESHOLD))
             {
-                temp_weights[i] *= pow(1.1, (30.0 - d->difficulty) / 3);
+                temp_weights[i] *= d->toptier_difficulty_multiplier;
             }
 
             if((d->difficulty < 30.0) && (d->piece_weights[i] >= QRS_WEIGHT_HIGHTIER_THRESHOLD) && (d->piece_weights[i] < QRS_WEIGHT_TOPTIER_THRESHOLD))
             {
-                temp_weights[i] *= pow(1.1, (30.0 - d->difficulty) / 6);
+                temp_weights[i] *= d->hightier_difficulty_multiplier;
             }
 
             sum += temp_weights[i];
@@ -719,18 +973,11 @@ piece_id histrand_get_next(struct randomizer *r)
         {
             // find which segment p is in
             if(p >= (long double)(sum) && p < (long double)(sum + temp_weights[i]))
-            {
-                free(temp_weights);
-                free(histogram);
                 return i;
-            }
             else
                 sum += temp_weights[i];
         }
 
-        free(temp_weights);
-        free(histogram);
-
         return 0;
     }
 
@@ -766,7 +1013,7 @@ piece_id g3rand_get_next(struct randomizer *r)
 
     for(i = 0; i < 6; i++)
     {
-        bagpos = g123_read_rand(r->seedp) % 35;
+        bagpos = g123_read_rand(&r->seed) % 35;
         piece = d->bag[bagpos];
 
         // piece is not in the history, this is fine
@@ -777,7 +1024,7 @@ piece_id g3rand_get_next(struct randomizer *r)
         d->bag[bagpos] = g3_most_droughted_piece(d->histogram);
 
         // We might be about to fall out of the loop, pick something at random
-        bagpos = g123_read_rand(r->seedp) % 35;
+        bagpos = g123_read_rand(&r->seed) % 35;
         piece = d->bag[bagpos];
     }
 
@@ -913,27 +1160,6 @@ rngstate from_hist_seed(char *history_str, uint32_t seed)
 }
 */
 
-uint32_t g2_get_seed() { return g2_seed; }
-
-uint32_t g2_seed_rand(uint32_t seed)
-{
-    g2_seed = seed;
-
-    return 0;
-}
-
-uint32_t g2_seed_bkp()
-{
-    g2_bkp_seed = g2_seed;
-    return 0;
-}
-
-uint32_t g2_seed_restore()
-{
-    g2_seed = g2_bkp_seed;
-    return 0;
-}
-
 uint32_t g2_rand(uint32_t n) { return (n * 0x41c64e6d + 12345); }
 
 uint32_t g2_rand_rep(uint32_t n, uint32_t reps)
@@ -968,8 +1194,7 @@ uint32_t g2_unrand_rep(uint32_t n, uint32_t reps)
 
 uint32_t g123_read_rand(uint32_t *seedp)
 {
-    if(!seedp)
-        seedp = &g2_seed;
+    assert(seedp != nullptr);
 
     *seedp = g2_rand(*seedp);
     return (*seedp >> 10) & 0x7fff;
@@ -982,8 +1207,7 @@ piece_id g123_get_init_piece(uint32_t *seedp)
 {
     piece_id t = 1;
 
-    if(!seedp)
-        seedp = &g2_seed;
+    assert(seedp != nullptr);
 
     while(t == 1 || t == 2 || t == 5)
     {
@@ -1,6 +1,7 @@
 #pragma once
 #include "QRS0.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #define RNGSTATE(STR, SEED) ((uint64_t)(STR[0]) << 56
 #define RNGSTATE_STRLEN 14
@@ -46,6 +47,9 @@
 #define QRS_WEIGHT_HIGHTIER_THRESHOLD 0.45
 #define QRS_WEIGHT_MIDTIER_THRESHOLD 0.25
 
+// drought times below this use precomputed multipliers, longer droughts fall back to pow()
+#define HISTRAND_DROUGHT_TABLE_LEN 64
+
 #define QRS_DROUGHT_HIGHTIER_SOFTLIMIT 20
 #define QRS_DROUGHT_MIDTIER_SOFTLIMIT 42
 #define QRS_DROUGHT_LOWTIER_SOFTLIMIT -1
@@ -86,7 +90,7 @@ typedef uint64_t seed64_t;
 struct randomizer
 {
     unsigned int num_pieces;
-    uint32_t *seedp;
+    uint32_t seed; // RNG state, owned by this randomizer alone
     int type;
 
     // TODO: implement PCG and make a read_rand() archetype to put here
@@ -115,6 +119,18 @@ struct histrand_data
     double *piece_weights;
     double *drought_protection_coefficients;
     unsigned int *drought_times;
+
+    // weighted randomizers only (NULL otherwise); scratch state for histrand_get_next so it doesn't allocate
+    // history_counts[i] is how many times piece i is in the history, kept in step by histrand_pull
+    unsigned int *history_counts;
+    double *scratch_weights;
+    // drought_multipliers[i * HISTRAND_DROUGHT_TABLE_LEN + t] = coefficient_i^(t/BASELINE)
+    double *drought_multipliers;
+
+    // pow(1.1, ...) factors for difficulty below 30, cached for difficulty_multipliers_for
+    double difficulty_multipliers_for;
+    double toptier_difficulty_multiplier;
+    double hightier_difficulty_multiplier;
 };
 
 // sakura_seq will be handled elsewhere as a non-randomizer-related piece_seq
@@ -133,8 +149,6 @@ int seed_is_after(uint32_t b, uint32_t a, unsigned int max_gap);
 
 /* */
 
-void g123_seeds_init();
-
 // TODO NULL-proof the functions which take struct randomizer * parameters
 
 // _create functions fill in all fields; piece_id arrays are filled with PIECE_ID_INVALID
@@ -144,6 +158,15 @@ struct randomizer *g3_randomizer_create(uint32_t flags);
 struct randomizer *pento_randomizer_create(uint32_t flags);
 void randomizer_destroy(struct randomizer *r);
 
+// deep copy, for snapshotting a randomizer mid-game
+struct randomizer *randomizer_clone(struct randomizer *r);
+// copies the RNG state and history of src into dst, which must be the same kind of randomizer
+void randomizer_copy_state(struct randomizer *dst, struct randomizer *src);
+// the same state as randomizer_copy_state, packed into randomizer_state_size(r) bytes; cheaper to keep many of than clones
+size_t randomizer_state_size(struct randomizer *r);
+void randomizer_save_state(struct randomizer *r, uint8_t *out);
+void randomizer_load_state(struct randomizer *r, const uint8_t *in);
+
 /* _init functions prepare a randomizer for the beginning of a new game
    i.e. they generate the first piece and move it to the beginning of the
    history (if applicable), and fill it in completely */
@@ -156,6 +179,7 @@ int pento_randomizer_init(struct randomizer *r, uint32_t *seed);
 void history_push(piece_id *history, unsigned int hist_len, piece_id t);
 piece_id history_pop(piece_id *history);
 bool in_history(piece_id *history, unsigned int hist_len, piece_id t);
+void histrand_count_history(struct randomizer *r);
 piece_id g3_most_droughted_piece(int *histogram);
 
 piece_id histrand_pull(struct randomizer *r);
@@ -178,11 +202,6 @@ rngstate state_set_hN(rngstate s, uint8_t n, uint8_t piece);
 rngstate from_hist_seed(char *history, uint32_t seed);
 */
 
-uint32_t g2_get_seed();
-uint32_t g2_seed_rand(uint32_t seed);
-uint32_t g2_seed_bkp();
-uint32_t g2_seed_restore();
-
 uint32_t g2_rand(uint32_t n);
 uint32_t g2_rand_rep(uint32_t n, uint32_t reps);
 uint32_t g2_unrand_rep(uint32_t n, uint32_t reps);
@@ -1,10 +1,13 @@
 #include "replay.h"
 #include "game_qs.h"
 #include "Input/KeyFlags.h"
+#include <algorithm>
+#include <array>
 #include <cstdlib>
 #include <cstring>
 #include <iomanip>
 #include <sstream>
+#include <utility>
 
 // clang-format off
 enum packed_input_mask {
@@ -47,11 +50,85 @@ void unpack_input(struct packed_input p, Shiro::KeyFlags *out_keys)
 }
 // clang-format on
 
-std::string get_replay_descriptor(struct replay *r)
+Shiro::ReplayInputBuffer::ReplayInputBuffer() :
+    length(0u) {}
+
+Shiro::ReplayInputBuffer::ReplayInputBuffer(const ReplayInputBuffer& other) :
+    length(0u)
+{
+    *this = other;
+}
+
+Shiro::ReplayInputBuffer::ReplayInputBuffer(ReplayInputBuffer&& other) noexcept :
+    chunks(std::move(other.chunks)),
+    length(other.length)
+{
+    other.chunks.clear();
+    other.length = 0u;
+}
+
+Shiro::ReplayInputBuffer& Shiro::ReplayInputBuffer::operator=(const ReplayInputBuffer& other)
+{
+    if(this != &other)
+    {
+        clear();
+        for(const auto& chunk : other.chunks)
+        {
+            chunks.emplace_back(new packed_input[chunkSize]);
+            std::copy(chunk.get(), chunk.get() + chunkSize, chunks.back().get());
+        }
+        length = other.length;
+    }
+
+    return *this;
+}
+
+Shiro::ReplayInputBuffer& Shiro::ReplayInputBuffer::operator=(ReplayInputBuffer&& other) noexcept
+{
+    if(this != &other)
+    {
+        chunks = std::move(other.chunks);
+        length = other.length;
+        other.chunks.clear();
+        other.length = 0u;
+    }
+
+    return *this;
+}
+
+std::size_t Shiro::ReplayInputBuffer::size() const { return length; }
+
+bool Shiro::ReplayInputBuffer::empty() const { return length == 0u; }
+
+void Shiro::ReplayInputBuffer::push_back(packed_input input)
+{
+    if(length == chunks.size() * chunkSize)
+        chunks.emplace_back(new packed_input[chunkSize]);
+
+    (*this)[length++] = input;
+}
+
+void Shiro::ReplayInputBuffer::clear()
+{
+    chunks.clear();
+    length = 0u;
+}
+
+packed_input& Shiro::ReplayInputBuffer::operator[](std::size_t index)
+{
+    return chunks[index / chunkSize][index % chunkSize];
+}
+
+const packed_input& Shiro::ReplayInputBuffer::operator[](std::size_t index) const
+{
+    return chunks[index / chunkSize][index % chunkSize];
+}
+
+std::string get_replay_descriptor(const Shiro::ReplayDescriptor &descriptor)
 {
     std::string modeString;
 
-    switch(r->mode)
+    switch(descriptor.mode)
     {
         case MODE_PENTOMINO:
             modeString = "PENTOMINO";
@@ -75,20 +152,20 @@ std::string get_replay_descriptor(struct replay *r)
             break;
     }
 
-    Shiro::Timer t(60.0, r->time);
+    Shiro::Timer t(60.0, descriptor.time);
 
     std::string dateString;
-    tm *ts = localtime(&r->date);
+    tm *ts = localtime(&descriptor.date);
     std::stringstream dateSS;
     dateSS << std::put_time(ts, "%Y.%m.%d");
     dateString = dateSS.str();
 
     std::stringstream returnSS;
     returnSS <<
-        get_grade_name(r->grade) << "  " <<
+        get_grade_name(descriptor.grade) << "  " <<
         std::setfill(' ') << std::left << std::setw(10) << modeString << " " <<
-        std::right << std::setw(4) << r->starting_level << "-" <<
-        std::left << std::setw(4) << r->ending_level << "  " <<
+        std::right << std::setw(4) << descriptor.startingLevel << "-" <<
+        std::left << std::setw(4) << descriptor.endingLevel << "  " <<
         std::setfill('0') << std::right <<
         std::setw(2) << t.min() << ":" <<
         std::setw(2) << t.sec() % 60 << ":" <<
@@ -111,81 +188,434 @@ std::string get_replay_descriptor(struct replay *r)
     */
 }
 
-// TODO: Use SDL endianness functions to ensure replay data is stored little
-// endian. The majority of players play on x86/x64 in older versions, so it'd
-// maintain compatibilty with old replays at first.
+std::string get_replay_descriptor(struct replay *r)
+{
+    return get_replay_descriptor({ r->index, r->mode, r->grade, r->starting_level, r->ending_level, r->time, r->date });
+}
+
+namespace {
+    // everything in a raw replay before its inputs
+    struct replay_header {
+        unsigned version;
+        const char *revision; // engine revision the replay was recorded with, not terminated; empty before version 3
+        size_t revisionLength;
+        int mode;
+        int mode_flags;
+        long seed;
+        int grade;
+        uint64_t time;
+        int starting_level;
+        int ending_level;
+        time_t date;
+        unsigned int len;
+        size_t inputsOffset;
+    };
+
+    // bounds-checked little-endian reads straight from a raw replay
+    struct replay_reader {
+        const uint8_t *scanner;
+        const uint8_t *end;
+
+        bool read(size_t bytes, uint64_t *out)
+        {
+            if(size_t(end - scanner) < bytes)
+                return false;
+
+            *out = 0;
+            for(size_t i = 0; i < bytes; i++)
+                *out |= uint64_t(scanner[i]) << (8 * i);
+            scanner += bytes;
+
+            return true;
+        }
+    };
+}
+
+// how the inputs of a version 2 or later replay are stored
+enum replay_input_encoding {
+    rie_raw  = 0, // one packed input per frame, like legacy replays
+    rie_runs = 1,
+};
+
+// where the fixed-position fields of a version 3 replay are
+enum replay_v3_layout {
+    rv3_version       = 4,  // u16
+    rv3_header_length = 6,  // u16, up to the inputs; fields added later go at its end
+    rv3_inputs_length = 8,  // u32, the encoding byte and the inputs
+    rv3_crc           = 12, // u32, CRC-32 of everything else
+    rv3_revision      = 16, // u8 length, then that many characters
+};
+
+// zlib's crc32(): pass the CRC of the data so far, starting from 0
+static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t length)
+{
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> table;
+        for(uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for(int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return table;
+    }();
+
+    crc ^= 0xFFFFFFFFu;
+    for(size_t i = 0; i < length; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Version 3 replays are little-endian with fixed-width fields: the magic
+// number, the replay_v3_layout fields, the engine revision, then mode, mode
+// flags, seed, grade, time, starting level, ending level, date and input
+// count; then a replay_input_encoding byte and the inputs.
+static bool read_replay_header_v3(const uint8_t *buffer, size_t bufferLength, struct replay_header *out_header)
+{
+    replay_reader header = { buffer, buffer + bufferLength };
+    uint64_t magic, version, headerLength, inputsLength, crc, revisionLength;
+
+    if(!header.read(4, &magic) ||
+       !header.read(2, &version) ||
+       !header.read(2, &headerLength) ||
+       !header.read(4, &inputsLength) ||
+       !header.read(4, &crc))
+        return false;
+
+    if(headerLength < rv3_revision || headerLength + inputsLength != bufferLength)
+        return false;
+
+    if(crc32(crc32(0, buffer, rv3_crc), buffer + rv3_revision, bufferLength - rv3_revision) != crc)
+        return false;
+
+    // nothing in the header can be read past its end
+    header.end = buffer + headerLength;
+
+    if(!header.read(1, &revisionLength) || size_t(header.end - header.scanner) < revisionLength)
+        return false;
+
+    out_header->revision = (const char *)header.scanner;
+    out_header->revisionLength = size_t(revisionLength);
+    header.scanner += revisionLength;
+
+    uint64_t mode, mode_flags, seed, grade, time, starting_level, ending_level, date, len;
+    if(!header.read(4, &mode) ||
+       !header.read(4, &mode_flags) ||
+       !header.read(8, &seed) ||
+       !header.read(4, &grade) ||
+       !header.read(8, &time) ||
+       !header.read(4, &starting_level) ||
+       !header.read(4, &ending_level) ||
+       !header.read(8, &date) ||
+       !header.read(4, &len))
+        return false;
+
+    out_header->version = unsigned(version);
+    out_header->mode = int32_t(mode);
+    out_header->mode_flags = int32_t(mode_flags);
+    out_header->seed = long(int64_t(seed));
+    out_header->grade = int32_t(grade);
+    out_header->time = time;
+    out_header->starting_level = int32_t(starting_level);
+    out_header->ending_level = int32_t(ending_level);
+    out_header->date = time_t(int64_t(date));
+    out_header->len = unsigned(len);
+    out_header->inputsOffset = size_t(headerLength);
+
+    return true;
+}
 
-void read_replay_from_memory(struct replay *out_replay, const uint8_t *buffer, size_t bufferLength)
+// Legacy replays (format version 1) are the header in native byte order, then
+// one packed input per frame. Version 2 replays have the same header, preceded
+// by the magic number and format version, and followed by a
+// replay_input_encoding byte and the inputs.
+static bool read_replay_header(const uint8_t *buffer, size_t bufferLength, struct replay_header *out_header)
 {
-    // Keep the same existing format
-    const uint8_t *scanner = buffer;
+    const size_t header_size = 6 * sizeof(int) + 3 * sizeof(long);
+    size_t offset = 0;
+    uint32_t magic = 0;
+    uint16_t version = 1;
+
+    if(bufferLength >= sizeof(uint32_t) + sizeof(uint16_t))
+    {
+        memcpy(&magic, buffer, sizeof(uint32_t));
+        memcpy(&version, buffer + sizeof(uint32_t), sizeof(uint16_t));
+    }
 
-    out_replay->mode = ((int *)scanner)[0];
+    if(magic != REPLAY_FORMAT_MAGIC)
+        version = 1;
+    else if(version == 3)
+        return read_replay_header_v3(buffer, bufferLength, out_header);
+    else if(version == 2)
+        offset = sizeof(uint32_t) + sizeof(uint16_t);
+    else
+        return false;
+
+    if(bufferLength - offset < header_size)
+        return false;
+
+    const uint8_t *scanner = buffer + offset;
+    long time, date;
+
+    out_header->version = version;
+    out_header->revision = "";
+    out_header->revisionLength = 0;
+
+    memcpy(&out_header->mode, scanner, sizeof(int));
     scanner += sizeof(int);
 
-    out_replay->mode_flags = ((int *)scanner)[0];
+    memcpy(&out_header->mode_flags, scanner, sizeof(int));
     scanner += sizeof(int);
 
-    out_replay->seed = ((long *)scanner)[0];
+    memcpy(&out_header->seed, scanner, sizeof(long));
     scanner += sizeof(long);
 
-    out_replay->grade = ((int *)scanner)[0];
+    memcpy(&out_header->grade, scanner, sizeof(int));
     scanner += sizeof(int);
 
-    out_replay->time = ((long *)scanner)[0];
+    memcpy(&time, scanner, sizeof(long));
     scanner += sizeof(long);
 
-    out_replay->starting_level = ((int *)scanner)[0];
+    memcpy(&out_header->starting_level, scanner, sizeof(int));
     scanner += sizeof(int);
 
-    out_replay->ending_level = ((int *)scanner)[0];
+    memcpy(&out_header->ending_level, scanner, sizeof(int));
     scanner += sizeof(int);
 
-    out_replay->date = ((long *)scanner)[0];
+    memcpy(&date, scanner, sizeof(long));
     scanner += sizeof(long);
 
-    out_replay->len = ((int *)scanner)[0];
+    memcpy(&out_header->len, scanner, sizeof(int));
     scanner += sizeof(int);
 
-    memcpy(&out_replay->pinputs[0], scanner, out_replay->len * sizeof(struct packed_input));
+    out_header->time = time;
+    out_header->date = date;
+    out_header->inputsOffset = size_t(scanner - buffer);
+    return true;
 }
 
-uint8_t *generate_raw_replay(struct replay *r, size_t *out_replayLength)
+Shiro::ReplayInputIterator::ReplayInputIterator(const uint8_t *buffer, std::size_t bufferLength) :
+    scanner(buffer),
+    end(buffer + bufferLength),
+    runs(false),
+    length(0u),
+    remaining(0u),
+    runRemaining(0u),
+    current({ 0 }),
+    ok(false)
 {
-    uint8_t *buffer = (uint8_t *)malloc(sizeof(struct replay));
-    size_t bufferOffset = 0;
+    struct replay_header header;
 
-    memcpy(buffer + bufferOffset, &r->mode, sizeof(int));
-    bufferOffset += sizeof(int);
+    if(!read_replay_header(buffer, bufferLength, &header))
+        return;
 
-    memcpy(buffer + bufferOffset, &r->mode_flags, sizeof(int));
-    bufferOffset += sizeof(int);
+    scanner = buffer + header.inputsOffset;
+    revisionName = std::string_view(header.revision, header.revisionLength);
+    length = header.len;
+    remaining = length;
 
-    memcpy(buffer + bufferOffset, &r->seed, sizeof(long));
-    bufferOffset += sizeof(long);
+    if(header.version != 1)
+    {
+        if(scanner == end || *scanner > rie_runs)
+            return;
 
-    memcpy(buffer + bufferOffset, &r->grade, sizeof(int));
-    bufferOffset += sizeof(int);
+        runs = *scanner++ == rie_runs;
+    }
 
-    memcpy(buffer + bufferOffset, &r->time, sizeof(long));
-    bufferOffset += sizeof(long);
+    // raw inputs are exactly one byte per frame
+    ok = runs || size_t(end - scanner) == size_t(length) * sizeof(struct packed_input);
+}
+
+bool Shiro::ReplayInputIterator::valid() const { return ok; }
+
+std::string_view Shiro::ReplayInputIterator::revision() const { return revisionName; }
+
+unsigned Shiro::ReplayInputIterator::frames() const { return length; }
+
+bool Shiro::ReplayInputIterator::finished() const
+{
+    return ok && remaining == 0 && runRemaining == 0 && scanner == end;
+}
+
+bool Shiro::ReplayInputIterator::readRun()
+{
+    if(scanner == end)
+        return false;
+
+    current.data ^= *scanner++;
+
+    // unsigned LEB128, at most 32 bits
+    uint32_t runLength = 0;
+    for(unsigned shift = 0;; shift += 7)
+    {
+        if(scanner == end)
+            return false;
+
+        const uint8_t byte = *scanner++;
+        if(shift == 28 && byte > 0x0F)
+            return false;
+
+        runLength |= uint32_t(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+            break;
+    }
+
+    if(runLength == 0 || runLength > remaining)
+        return false;
+
+    runRemaining = runLength;
+    return true;
+}
+
+bool Shiro::ReplayInputIterator::next(packed_input &out)
+{
+    if(!ok || remaining == 0)
+        return false;
+
+    if(!runs)
+    {
+        out = *reinterpret_cast<const packed_input *>(scanner);
+        scanner += sizeof(struct packed_input);
+    }
+    else
+    {
+        if(runRemaining == 0 && !readRun())
+        {
+            ok = false;
+            return false;
+        }
+
+        runRemaining--;
+        out = current;
+    }
+
+    remaining--;
+    return true;
+}
+
+bool read_replay_from_memory(struct replay *out_replay, const uint8_t *buffer, size_t bufferLength)
+{
+    struct replay_header header;
 
-    memcpy(buffer + bufferOffset, &r->starting_level, sizeof(int));
-    bufferOffset += sizeof(int);
+    out_replay->pinputs.clear();
 
-    memcpy(buffer + bufferOffset, &r->ending_level, sizeof(int));
-    bufferOffset += sizeof(int);
+    if(!read_replay_header(buffer, bufferLength, &header))
+        return false;
 
-    memcpy(buffer + bufferOffset, &r->date, sizeof(long));
-    bufferOffset += sizeof(long);
+    out_replay->mode = header.mode;
+    out_replay->mode_flags = header.mode_flags;
+    out_replay->seed = header.seed;
+    out_replay->grade = header.grade;
+    out_replay->time = header.time;
+    out_replay->starting_level = header.starting_level;
+    out_replay->ending_level = header.ending_level;
+    out_replay->date = header.date;
 
-    memcpy(buffer + bufferOffset, &r->len, sizeof(int));
-    bufferOffset += sizeof(int);
+    Shiro::ReplayInputIterator inputs(buffer, bufferLength);
+    struct packed_input input;
+
+    while(inputs.next(input))
+        out_replay->pinputs.push_back(input);
+
+    if(!inputs.finished())
+    {
+        out_replay->pinputs.clear();
+        return false;
+    }
+
+    return true;
+}
+
+static uint8_t *write_varint(uint8_t *scanner, uint32_t value)
+{
+    while(value >= 0x80)
+    {
+        *scanner++ = uint8_t(value | 0x80);
+        value >>= 7;
+    }
+    *scanner++ = uint8_t(value);
+
+    return scanner;
+}
+
+static uint8_t *write_le(uint8_t *scanner, uint64_t value, size_t bytes)
+{
+    for(size_t i = 0; i < bytes; i++)
+        *scanner++ = uint8_t(value >> (8 * i));
+
+    return scanner;
+}
+
+static_assert(sizeof(PENTOMINO_C_REVISION_STRING) <= 256, "the revision's length has to fit in a byte");
+
+uint8_t *generate_raw_replay(struct replay *r, size_t *out_replayLength)
+{
+    const size_t len = r->pinputs.size();
+    const size_t revisionLength = strlen(PENTOMINO_C_REVISION_STRING);
+    const size_t headerLength = rv3_revision + 1 + revisionLength + 4 + 4 + 8 + 4 + 8 + 4 + 4 + 8 + 4;
+
+    // every run takes at most a delta byte and a five byte varint
+    uint8_t *buffer = (uint8_t *)malloc(headerLength + 1 + len * 6);
+    uint8_t *scanner = buffer;
+
+    // the lengths and CRC are filled in once the inputs are written
+    scanner = write_le(scanner, REPLAY_FORMAT_MAGIC, 4);
+    scanner = write_le(scanner, REPLAY_FORMAT_VERSION, 2);
+    scanner = write_le(scanner, headerLength, 2);
+    scanner = write_le(scanner, 0, 4);
+    scanner = write_le(scanner, 0, 4);
+
+    scanner = write_le(scanner, revisionLength, 1);
+    memcpy(scanner, PENTOMINO_C_REVISION_STRING, revisionLength);
+    scanner += revisionLength;
+
+    scanner = write_le(scanner, uint32_t(r->mode), 4);
+    scanner = write_le(scanner, r->mode_flags, 4);
+    scanner = write_le(scanner, uint64_t(int64_t(r->seed)), 8);
+    scanner = write_le(scanner, uint32_t(r->grade), 4);
+    scanner = write_le(scanner, r->time, 8);
+    scanner = write_le(scanner, uint32_t(r->starting_level), 4);
+    scanner = write_le(scanner, uint32_t(r->ending_level), 4);
+    scanner = write_le(scanner, uint64_t(int64_t(r->date)), 8);
+    scanner = write_le(scanner, len, 4);
+
+    uint8_t *encoding = scanner;
+    scanner = encoding + 1;
+    uint8_t previous = 0;
+
+    for(size_t i = 0; i < len;)
+    {
+        const uint8_t input = r->pinputs[i].data;
+        uint32_t run = 1;
+
+        while(i + run < len && r->pinputs[i + run].data == input)
+            run++;
+
+        *scanner++ = input ^ previous;
+        scanner = write_varint(scanner, run);
+
+        previous = input;
+        i += run;
+    }
+
+    *encoding = rie_runs;
+
+    // inputs that change nearly every frame are smaller stored as they are
+    if(size_t(scanner - (encoding + 1)) >= len * sizeof(struct packed_input))
+    {
+        *encoding = rie_raw;
+        scanner = encoding + 1;
+        for(size_t i = 0; i < len; i++)
+            *scanner++ = r->pinputs[i].data;
+    }
 
-    memcpy(buffer + bufferOffset, &r->pinputs, sizeof(struct packed_input) * r->len);
-    bufferOffset += sizeof(struct packed_input) * r->len;
+    const size_t length = size_t(scanner - buffer);
+    write_le(buffer + rv3_inputs_length, length - headerLength, 4);
+    write_le(buffer + rv3_crc, crc32(crc32(0, buffer, rv3_crc), buffer + rv3_revision, length - rv3_revision), 4);
 
-    *out_replayLength = bufferOffset;
+    *out_replayLength = length;
 
     return buffer;
 }
@@ -1,10 +1,18 @@
 #pragma once
 #define NO_REPLAY -1
-#define MAX_KEYFLAGS 72000 // 20 minutes of inputs (@ 60 fps)
 #include "Input/KeyFlags.h"
 #include <string>
 #include <ctime>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Raw replays written since format version 2 start with this, which no legacy
+// replay can: legacy replays start with their mode number.
+#define REPLAY_FORMAT_MAGIC 0x4C505253u // "SRPL"
+#define REPLAY_FORMAT_VERSION 3
 
 struct packed_input {
     uint8_t data;
@@ -13,10 +21,59 @@ struct packed_input {
 struct packed_input pack_input(Shiro::KeyFlags *k);
 void unpack_input(struct packed_input p, Shiro::KeyFlags *out_keys);
 
-struct replay {
-    unsigned int len;
-    unsigned int mlen;
+namespace Shiro {
+    /**
+     * A replay's inputs, one per frame, in fixed-size chunks allocated as
+     * the replay grows. There's no limit on the number of inputs, and
+     * appending never moves the inputs already stored, so recording costs
+     * the same on every frame. Moving a buffer moves its chunks.
+     */
+    class ReplayInputBuffer {
+    public:
+        static constexpr std::size_t chunkSize = 1u << 12; // a bit over a minute at 60 FPS
+
+        ReplayInputBuffer();
+        ReplayInputBuffer(const ReplayInputBuffer& other);
+        ReplayInputBuffer(ReplayInputBuffer&& other) noexcept;
+        ReplayInputBuffer& operator=(const ReplayInputBuffer& other);
+        ReplayInputBuffer& operator=(ReplayInputBuffer&& other) noexcept;
+
+        std::size_t size() const;
+        bool empty() const;
+
+        void push_back(packed_input input);
+
+        /**
+         * Removes every input, freeing the chunks.
+         */
+        void clear();
+
+        packed_input& operator[](std::size_t index);
+        const packed_input& operator[](std::size_t index) const;
+
+    private:
+        std::vector<std::unique_ptr<packed_input[]>> chunks;
+        std::size_t length;
+    };
+}
+
+namespace Shiro {
+    /**
+     * The parts of a stored replay that replay lists show, without its
+     * inputs. The score ID is the replay's ID in the scores database.
+     */
+    struct ReplayDescriptor {
+        int scoreId;
+        int mode;
+        int grade;
+        int startingLevel;
+        int endingLevel;
+        std::uint64_t time;
+        std::time_t date;
+    };
+}
 
+struct replay {
     int mode;
     unsigned int mode_flags;
     long seed;
@@ -29,12 +86,73 @@ struct replay {
 
     int index;
 
-    struct packed_input pinputs[MAX_KEYFLAGS];
+    Shiro::ReplayInputBuffer pinputs;
 };
 
+std::string get_replay_descriptor(const Shiro::ReplayDescriptor &descriptor);
 std::string get_replay_descriptor(struct replay *r);
 
-void read_replay_from_memory(struct replay *out_replay, const uint8_t *buffer, size_t bufferLength);
+// Reads a raw replay of any format version. Returns false if it's malformed or
+// fails its checksum, in which case out_replay is left with no inputs.
+bool read_replay_from_memory(struct replay *out_replay, const uint8_t *buffer, size_t bufferLength);
 
+// Writes the current format version: a little-endian header with the engine
+// revision, lengths and a CRC-32, then the replay's inputs, stored as runs of
+// identical inputs, each the XOR of its input with the previous run's followed
+// by its length as a varint; or one byte per frame, if that's smaller.
 uint8_t* generate_raw_replay(struct replay *r, size_t *out_replayLength);
-void dispose_raw_replay(uint8_t* buffer);
\ No newline at end of file
+void dispose_raw_replay(uint8_t* buffer);
+
+namespace Shiro {
+    /**
+     * Decodes the inputs of a raw replay one frame at a time, straight from
+     * the raw replay's buffer, for any format version. The buffer must
+     * outlive the iterator.
+     */
+    class ReplayInputIterator {
+    public:
+        ReplayInputIterator(const uint8_t* buffer, std::size_t bufferLength);
+
+        /**
+         * False if the header is malformed, or once next() has run into
+         * malformed input data.
+         */
+        bool valid() const;
+
+        /**
+         * The engine revision the replay was recorded with, pointing into
+         * the buffer; empty for replays older than format version 3.
+         */
+        std::string_view revision() const;
+
+        /**
+         * The number of frames of inputs the header says the replay has.
+         */
+        unsigned frames() const;
+
+        /**
+         * Gets the next frame's input. Returns false once every frame has
+         * been read, or if the input data is malformed.
+         */
+        bool next(packed_input& out);
+
+        /**
+         * True once every frame has been read and the input data ended
+         * exactly where it should.
+         */
+        bool finished() const;
+
+    private:
+        bool readRun();
+
+        const uint8_t* scanner;
+        const uint8_t* end;
+        std::string_view revisionName;
+        bool runs;
+        unsigned length;
+        unsigned remaining;
+        unsigned runRemaining;
+        packed_input current;
+        bool ok;
+    };
+}
\ No newline at end of file